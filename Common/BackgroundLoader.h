@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    BackgroundLoader.h
+
+    Loads a processor's model once, on a thread of its own, and hands it to
+    the audio thread through an atomic pointer. Reading and optimising a
+    model takes far longer than a block, so neither the message thread nor
+    prepareToPlay waits for it: processBlock asks get() and passes the audio
+    through while it still returns nullptr.
+
+    The job started on the loader thread builds the model and ends by calling
+    publish(), after filling in whatever the audio thread reads together with
+    it (bindings, buffers); the release store makes all of that visible to the
+    acquire load in get(). A model is published once and lives as long as
+    the loader, so the audio thread never has to hold on to it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace neural
+{
+
+//==============================================================================
+template <typename Model>
+class BackgroundLoader
+{
+public:
+    BackgroundLoader() = default;
+
+    ~BackgroundLoader()
+    {
+        waitUntilFinished();
+    }
+
+    // Runs job() on the loader thread; the first job calls publish() when it
+    // is done. Later ones (measuring an arena) wait for the one before.
+    template <typename Job>
+    void start (Job&& job)
+    {
+        waitUntilFinished();
+        worker = std::thread (std::forward<Job> (job));
+    }
+
+    // Hands the model to the audio thread. Call it once per loader.
+    void publish (std::unique_ptr<Model> newModel)
+    {
+        model = std::move (newModel);
+        published.store (model.get(), std::memory_order_release);
+    }
+
+    // nullptr until the model has been published; never blocks
+    const Model* get() const                    { return published.load (std::memory_order_acquire); }
+
+    // The owner calls this first in its destructor, as the job uses its members
+    void waitUntilFinished()
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+
+private:
+    std::unique_ptr<Model> model;
+    std::atomic<const Model*> published { nullptr };
+    std::thread worker;
+
+    BackgroundLoader (const BackgroundLoader&) = delete;
+    BackgroundLoader& operator= (const BackgroundLoader&) = delete;
+};
+
+} // namespace neural
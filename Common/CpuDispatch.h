@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+    CpuDispatch.h
+
+    Lets one binary use the widest vector unit of whatever machine it lands
+    on: AVX-512 on the render nodes, AVX2 on most desktops, SSE2 or plain
+    scalar code on anything older. The CPU (and the OS's register saving) is
+    probed through CPUID once per process, and a kernel is compiled once per
+    instruction set so the matching copy can be picked when a plugin loads.
+
+    A kernel is a struct with a static run() templated on the fastmath lane
+    operations; everything it calls is inlined into an entry function built
+    for the matching target:
+
+        struct LimitKernel
+        {
+            template <typename Ops>
+            static void run (const float* in, float* out, int n)   { fastmath::tanh<Ops> (in, out, n); }
+        };
+
+        auto* limit = SimdDispatch<LimitKernel>::select<const float*, float*, int>();
+
+    Setting NEURAL_SIMD=scalar, sse2 or avx2 in the environment caps the
+    choice, to compare the paths on one machine. Unoptimised GCC / Clang
+    builds never go past SSE2 (see NEURAL_SIMD_WIDE_ENTRIES).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include "FastMath.h"
+
+#if NEURAL_FASTMATH_X86
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+namespace neural
+{
+
+//==============================================================================
+enum class SimdLevel
+{
+    scalar,
+    sse2,
+    avx2,       // with FMA
+    avx512,     // AVX-512F
+    neon
+};
+
+inline const char* getSimdLevelName (SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdLevel::sse2:   return "SSE2";
+        case SimdLevel::avx2:   return "AVX2";
+        case SimdLevel::avx512: return "AVX-512";
+        case SimdLevel::neon:   return "NEON";
+        case SimdLevel::scalar:
+        default:                return "Scalar";
+    }
+}
+
+namespace detail
+{
+
+#if NEURAL_FASTMATH_X86
+inline void cpuid (unsigned int leaf, unsigned int subleaf, unsigned int (&regs)[4])
+{
+   #if defined (_MSC_VER)
+    int r[4];
+    __cpuidex (r, (int) leaf, (int) subleaf);
+
+    for (int i = 0; i < 4; ++i)
+        regs[i] = (unsigned int) r[i];
+   #else
+    __cpuid_count (leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+   #endif
+}
+
+// Which register files the OS saves on a context switch
+inline unsigned long long readXcr0()
+{
+   #if defined (_MSC_VER)
+    return _xgetbv (0);
+   #else
+    unsigned int low, high;
+    __asm__ volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+    return ((unsigned long long) high << 32) | low;
+   #endif
+}
+#endif
+
+inline SimdLevel detectSimdLevel()
+{
+   #if NEURAL_FASTMATH_X86
+    unsigned int regs[4];
+
+    cpuid (0, 0, regs);
+    const auto maxLeaf = regs[0];
+
+    cpuid (1, 0, regs);
+    const bool hasSse2    = (regs[3] & (1u << 26)) != 0;
+    const bool hasFma     = (regs[2] & (1u << 12)) != 0;
+    const bool hasOsxsave = (regs[2] & (1u << 27)) != 0;
+    const bool hasAvx     = (regs[2] & (1u << 28)) != 0;
+
+    if (! hasSse2)
+        return SimdLevel::scalar;
+
+    if (! (hasOsxsave && hasAvx && hasFma) || maxLeaf < 7)
+        return SimdLevel::sse2;
+
+    // XMM and YMM state, plus opmask and both ZMM halves for AVX-512
+    const auto xcr0 = readXcr0();
+
+    if ((xcr0 & 0x06) != 0x06)
+        return SimdLevel::sse2;
+
+    cpuid (7, 0, regs);
+    const bool hasAvx2    = (regs[1] & (1u << 5)) != 0;
+    const bool hasAvx512f = (regs[1] & (1u << 16)) != 0;
+
+    if (hasAvx2 && hasAvx512f && (xcr0 & 0xe6) == 0xe6)
+        return SimdLevel::avx512;
+
+    return hasAvx2 ? SimdLevel::avx2 : SimdLevel::sse2;
+   #elif NEURAL_FASTMATH_AARCH64
+    return SimdLevel::neon;
+   #else
+    return SimdLevel::scalar;
+   #endif
+}
+
+// NEURAL_SIMD can only lower the level, never enable what the CPU lacks
+inline SimdLevel applySimdLevelOverride (SimdLevel detected)
+{
+   #if ! NEURAL_SIMD_WIDE_ENTRIES
+    if (detected == SimdLevel::avx2 || detected == SimdLevel::avx512)
+        detected = SimdLevel::sse2;
+   #endif
+
+    const char* requested = std::getenv ("NEURAL_SIMD");
+
+    if (requested == nullptr)
+        return detected;
+
+    struct Option { const char* name; SimdLevel level; };
+
+    const Option options[] = { { "scalar", SimdLevel::scalar },
+                               { "sse2",   SimdLevel::sse2 },
+                               { "avx2",   SimdLevel::avx2 } };
+
+    for (auto& option : options)
+        if (std::strcmp (requested, option.name) == 0)
+            if (option.level == SimdLevel::scalar || (detected != SimdLevel::neon && option.level < detected))
+                return option.level;
+
+    return detected;
+}
+
+} // namespace detail
+
+// The level every SimdDispatch::select() defaults to, probed on first use
+inline SimdLevel getSimdLevel()
+{
+    static const SimdLevel level = detail::applySimdLevelOverride (detail::detectSimdLevel());
+    return level;
+}
+
+//==============================================================================
+/**
+    One copy of Kernel::run per instruction set this build can target, and a
+    function pointer to the right one.
+*/
+template <typename Kernel>
+struct SimdDispatch
+{
+    template <typename... Args>
+    using Function = void (*) (Args...);
+
+    template <typename... Args>
+    static Function<Args...> select (SimdLevel level = getSimdLevel())
+    {
+        switch (level)
+        {
+           #if NEURAL_FASTMATH_X86
+           #if NEURAL_SIMD_WIDE_ENTRIES
+            case SimdLevel::avx512: return &runAvx512<Args...>;
+            case SimdLevel::avx2:   return &runAvx2<Args...>;
+           #endif
+            case SimdLevel::sse2:   return &runSse2<Args...>;
+           #elif NEURAL_FASTMATH_AARCH64
+            case SimdLevel::neon:   return &runNeon<Args...>;
+           #endif
+            default:                return &runScalar<Args...>;
+        }
+    }
+
+    // The entry built for a given set of lane operations, for code already
+    // running in one that needs the same instruction set on another thread
+    template <typename Ops, typename... Args>
+    static Function<Args...> entryFor()
+    {
+       #if NEURAL_FASTMATH_X86
+       #if NEURAL_SIMD_WIDE_ENTRIES
+        if constexpr (std::is_same_v<Ops, fastmath::Avx512Ops>) return &runAvx512<Args...>;
+        if constexpr (std::is_same_v<Ops, fastmath::Avx2Ops>)   return &runAvx2<Args...>;
+       #endif
+        if constexpr (std::is_same_v<Ops, fastmath::Sse2Ops>)   return &runSse2<Args...>;
+       #elif NEURAL_FASTMATH_AARCH64
+        if constexpr (std::is_same_v<Ops, fastmath::NeonOps>)   return &runNeon<Args...>;
+       #endif
+        return &runScalar<Args...>;
+    }
+
+private:
+   #if NEURAL_FASTMATH_X86
+   #if NEURAL_SIMD_WIDE_ENTRIES
+    template <typename... Args>
+    NEURAL_SIMD_ENTRY_AVX512 static void runAvx512 (Args... args)  { Kernel::template run<fastmath::Avx512Ops> (args...); }
+
+    template <typename... Args>
+    NEURAL_SIMD_ENTRY_AVX2 static void runAvx2 (Args... args)      { Kernel::template run<fastmath::Avx2Ops> (args...); }
+   #endif
+
+    template <typename... Args>
+    NEURAL_SIMD_ENTRY static void runSse2 (Args... args)           { Kernel::template run<fastmath::Sse2Ops> (args...); }
+   #elif NEURAL_FASTMATH_AARCH64
+    template <typename... Args>
+    NEURAL_SIMD_ENTRY static void runNeon (Args... args)           { Kernel::template run<fastmath::NeonOps> (args...); }
+   #endif
+
+    template <typename... Args>
+    NEURAL_SIMD_ENTRY static void runScalar (Args... args)         { Kernel::template run<fastmath::ScalarOps> (args...); }
+};
+
+//==============================================================================
+// fastmath::softLimit as a dispatchable kernel, for output stages that sit
+// outside a dispatched model (e.g. after an ONNX Runtime call)
+struct SoftLimitKernel
+{
+    template <typename Ops>
+    static void run (const float* input, float* output, int numSamples, float threshold)
+    {
+        fastmath::softLimit<Ops> (input, output, numSamples, threshold);
+    }
+};
+
+} // namespace neural
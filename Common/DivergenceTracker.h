@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    DivergenceTracker.h
+
+    Keeps the largest absolute difference seen between two inference paths,
+    one figure per tensor (the output, then each state the ONNX session
+    returns), for the processors' shadow comparison mode. compare() is called
+    from the audio thread and never allocates or locks; the figures can be
+    read from any thread while it runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace neural
+{
+
+//==============================================================================
+class DivergenceTracker
+{
+public:
+    static constexpr int maxTensors = 8;
+
+    // The names are not copied, so they must outlive the tracker (the
+    // processors pass their ONNX output names). Also clears the figures.
+    void setTensorNames (const char* const* names, int numNames)
+    {
+        numTensors = numNames < maxTensors ? numNames : maxTensors;
+
+        for (int i = 0; i < numTensors; ++i)
+            tensorNames[i] = names[i];
+
+        reset();
+    }
+
+    int getNumTensors() const                   { return numTensors; }
+    const char* getTensorName (int tensor) const { return tensorNames[tensor]; }
+
+    // Folds max |a[i] - b[i]| into the tensor's figure; NaN counts as infinite
+    void compare (int tensor, const float* a, const float* b, int size)
+    {
+        if (tensor >= numTensors)
+            return;
+
+        auto largest = 0.0f;
+
+        for (int i = 0; i < size; ++i)
+        {
+            auto difference = std::abs (a[i] - b[i]);
+
+            if (! (difference <= largest))
+                largest = std::isnan (difference) ? std::numeric_limits<float>::infinity() : difference;
+        }
+
+        auto& figure = maxErrors[tensor];
+        auto current = figure.load (std::memory_order_relaxed);
+
+        while (largest > current)
+            if (figure.compare_exchange_weak (current, largest, std::memory_order_relaxed))
+                break;
+    }
+
+    void blockCompared()                        { numBlocks.fetch_add (1, std::memory_order_relaxed); }
+
+    float getMaxError (int tensor) const        { return maxErrors[tensor].load (std::memory_order_relaxed); }
+    uint64_t getNumBlocks() const               { return numBlocks.load (std::memory_order_relaxed); }
+
+    void reset()
+    {
+        for (auto& figure : maxErrors)
+            figure.store (0.0f, std::memory_order_relaxed);
+
+        numBlocks.store (0, std::memory_order_relaxed);
+    }
+
+    // e.g. "120 blocks, output 2.4e-07, new_h 1.1e-07"
+    std::string getSummary() const
+    {
+        auto summary = std::to_string (getNumBlocks()) + " blocks";
+
+        for (int i = 0; i < numTensors; ++i)
+        {
+            char figure[32];
+            std::snprintf (figure, sizeof (figure), " %.2g", (double) getMaxError (i));
+            summary += std::string (", ") + tensorNames[i] + figure;
+        }
+
+        return summary;
+    }
+
+private:
+    const char* tensorNames[maxTensors] {};
+    int numTensors = 0;
+    std::atomic<float> maxErrors[maxTensors] {};
+    std::atomic<uint64_t> numBlocks { 0 };
+};
+
+// NEURAL_SHADOW=1 in the environment starts the processors with the
+// comparison on, so it can be used in a host without touching the UI
+inline bool isShadowComparisonRequested()
+{
+    const char* requested = std::getenv ("NEURAL_SHADOW");
+    return requested != nullptr && std::strcmp (requested, "1") == 0;
+}
+
+} // namespace neural
@@ -0,0 +1,553 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Vectorised approximations of the transcendental functions the models
+    spend their time in: exp, tanh, sigmoid, softplus and erf. Each one is
+    written once against a tiny set of lane operations (the *Ops structs) and
+    instantiated for AVX-512, AVX2, SSE2, AArch64 NEON and plain scalar code.
+    The block versions take the Ops to use as a template argument, defaulting
+    to the widest set the translation unit is compiled for; CpuDispatch.h
+    instantiates them for the others and picks one at runtime. A remainder
+    shorter than a register goes through the next narrower set, so where a
+    sample falls in a block changes its result by one rounding at most (FMA).
+
+    Maximum error against the double-precision functions, measured on a dense
+    float grid over [-40, 40] plus the clamping edges, in every instantiation:
+
+        exp        relative 1.2e-7     results in the normal range (x > -87)
+        tanh       absolute 1.2e-7
+        sigmoid    absolute 1.0e-7
+        softplus   relative 2.3e-7     absolute 4.8e-7 (the rounding of x > 4)
+        erf        absolute 4.7e-7
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+ #define NEURAL_FASTMATH_X86 1
+ #include <immintrin.h>
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #define NEURAL_FASTMATH_AARCH64 1
+ #include <arm_neon.h>
+#endif
+
+// The AVX2 and AVX-512 lane operations are compiled on every x86 build,
+// whatever its baseline. GCC and Clang only accept their intrinsics inside
+// functions that name the target, and their vector arguments only travel
+// correctly between functions of that target, so Avx2Ops / Avx512Ops must
+// only be used from code that ends up inlined into a NEURAL_SIMD_ENTRY_*
+// function: the entry names the target and flattens everything below it
+// into itself. CpuDispatch.h generates such entries; MSVC needs neither.
+#if defined (__GNUC__) || defined (__clang__)
+ #define NEURAL_SIMD_ENTRY          __attribute__ ((flatten))
+#else
+ #define NEURAL_SIMD_ENTRY
+#endif
+
+// Without optimisation nothing is inlined, flatten included, so debug builds
+// keep to the baseline lane operations
+#if NEURAL_FASTMATH_X86 && (defined (__GNUC__) || defined (__clang__)) && ! defined (__OPTIMIZE__)
+ #define NEURAL_SIMD_WIDE_ENTRIES 0
+#else
+ #define NEURAL_SIMD_WIDE_ENTRIES 1
+#endif
+
+#if NEURAL_FASTMATH_X86 && (defined (__GNUC__) || defined (__clang__))
+ #define NEURAL_TARGET_AVX2         __attribute__ ((target ("avx2,fma")))
+ #define NEURAL_TARGET_AVX512       __attribute__ ((target ("avx512f,avx2,fma")))
+ #define NEURAL_SIMD_ENTRY_AVX2     __attribute__ ((flatten, target ("avx2,fma")))
+ #define NEURAL_SIMD_ENTRY_AVX512   __attribute__ ((flatten, target ("avx512f,avx2,fma")))
+#else
+ #define NEURAL_TARGET_AVX2
+ #define NEURAL_TARGET_AVX512
+ #define NEURAL_SIMD_ENTRY_AVX2
+ #define NEURAL_SIMD_ENTRY_AVX512
+#endif
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ // The generic functions below take and return vectors through references,
+ // so no function without the AVX target has a vector in its signature. Their
+ // calls to the lane operations still pass __m256 / __m512 by value; those
+ // only ever run flattened into an entry of the right target, so GCC's ABI
+ // note for them does not apply. It is reported at the call, in this header,
+ // so turning it off here covers every instantiation.
+ #pragma GCC diagnostic push
+ #pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace neural
+{
+namespace fastmath
+{
+
+//==============================================================================
+struct ScalarOps
+{
+    using V = float;
+    using I = int32_t;
+    static constexpr int width = 1;
+    using Narrower = ScalarOps;
+
+    static V load (const float* p)                         { return *p; }
+    static void store (float* p, V v)                      { *p = v; }
+    static V set (float x)                                 { return x; }
+    static V add (V a, V b)                                { return a + b; }
+    static V sub (V a, V b)                                { return a - b; }
+    static V mul (V a, V b)                                { return a * b; }
+    static V div (V a, V b)                                { return a / b; }
+    static V madd (V a, V b, V c)                          { return a * b + c; }
+    static V min (V a, V b)                                { return a < b ? a : b; }
+    static V max (V a, V b)                                { return a > b ? a : b; }
+    static V abs (V a)                                     { return std::abs (a); }
+    static V copySign (V magnitude, V sign)                { return std::copysign (magnitude, sign); }
+    static V selectGreater (V a, V b, V ifTrue, V ifFalse) { return a > b ? ifTrue : ifFalse; }
+    static I roundToInt (V a)                              { return (I) std::nearbyint (a); }
+    static V toFloat (I a)                                 { return (V) a; }
+
+    // 2^n for integer n in the normal float range
+    static V pow2 (I n)
+    {
+        auto bits = (uint32_t) (n + 127) << 23;
+        V result;
+        std::memcpy (&result, &bits, sizeof (result));
+        return result;
+    }
+
+    // Splits x > 0 into mantissa in [1, 2) and exponent
+    static V splitExponent (V x, V& exponent)
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        exponent = (V) ((int32_t) (bits >> 23) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        std::memcpy (&x, &bits, sizeof (x));
+        return x;
+    }
+};
+
+//==============================================================================
+#if NEURAL_FASTMATH_X86
+struct Sse2Ops
+{
+    using V = __m128;
+    using I = __m128i;
+    static constexpr int width = 4;
+    using Narrower = ScalarOps;
+
+    static V load (const float* p)              { return _mm_loadu_ps (p); }
+    static void store (float* p, V v)           { _mm_storeu_ps (p, v); }
+    static V set (float x)                      { return _mm_set1_ps (x); }
+    static V add (V a, V b)                     { return _mm_add_ps (a, b); }
+    static V sub (V a, V b)                     { return _mm_sub_ps (a, b); }
+    static V mul (V a, V b)                     { return _mm_mul_ps (a, b); }
+    static V div (V a, V b)                     { return _mm_div_ps (a, b); }
+    static V madd (V a, V b, V c)               { return _mm_add_ps (_mm_mul_ps (a, b), c); }
+    static V min (V a, V b)                     { return _mm_min_ps (a, b); }
+    static V max (V a, V b)                     { return _mm_max_ps (a, b); }
+    static V abs (V a)                          { return _mm_andnot_ps (_mm_set1_ps (-0.0f), a); }
+
+    static V copySign (V magnitude, V sign)
+    {
+        auto signBit = _mm_set1_ps (-0.0f);
+        return _mm_or_ps (_mm_andnot_ps (signBit, magnitude), _mm_and_ps (signBit, sign));
+    }
+
+    static V selectGreater (V a, V b, V ifTrue, V ifFalse)
+    {
+        auto mask = _mm_cmpgt_ps (a, b);
+        return _mm_or_ps (_mm_and_ps (mask, ifTrue), _mm_andnot_ps (mask, ifFalse));
+    }
+
+    static I roundToInt (V a)                   { return _mm_cvtps_epi32 (a); }
+    static V toFloat (I a)                      { return _mm_cvtepi32_ps (a); }
+
+    static V pow2 (I n)
+    {
+        return _mm_castsi128_ps (_mm_slli_epi32 (_mm_add_epi32 (n, _mm_set1_epi32 (127)), 23));
+    }
+
+    static V splitExponent (V x, V& exponent)
+    {
+        auto bits = _mm_castps_si128 (x);
+        exponent = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127)));
+        bits = _mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi32 (0x007fffff)), _mm_set1_epi32 (0x3f800000));
+        return _mm_castsi128_ps (bits);
+    }
+};
+
+//==============================================================================
+struct Avx2Ops
+{
+    using V = __m256;
+    using I = __m256i;
+    static constexpr int width = 8;
+    using Narrower = Sse2Ops;
+
+    NEURAL_TARGET_AVX2 static V load (const float* p)    { return _mm256_loadu_ps (p); }
+    NEURAL_TARGET_AVX2 static void store (float* p, V v) { _mm256_storeu_ps (p, v); }
+    NEURAL_TARGET_AVX2 static V set (float x)            { return _mm256_set1_ps (x); }
+    NEURAL_TARGET_AVX2 static V add (V a, V b)           { return _mm256_add_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V sub (V a, V b)           { return _mm256_sub_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V mul (V a, V b)           { return _mm256_mul_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V div (V a, V b)           { return _mm256_div_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V madd (V a, V b, V c)     { return _mm256_fmadd_ps (a, b, c); }
+    NEURAL_TARGET_AVX2 static V min (V a, V b)           { return _mm256_min_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V max (V a, V b)           { return _mm256_max_ps (a, b); }
+    NEURAL_TARGET_AVX2 static V abs (V a)                { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a); }
+
+    NEURAL_TARGET_AVX2 static V copySign (V magnitude, V sign)
+    {
+        auto signBit = _mm256_set1_ps (-0.0f);
+        return _mm256_or_ps (_mm256_andnot_ps (signBit, magnitude), _mm256_and_ps (signBit, sign));
+    }
+
+    NEURAL_TARGET_AVX2 static V selectGreater (V a, V b, V ifTrue, V ifFalse)
+    {
+        return _mm256_blendv_ps (ifFalse, ifTrue, _mm256_cmp_ps (a, b, _CMP_GT_OQ));
+    }
+
+    NEURAL_TARGET_AVX2 static I roundToInt (V a)         { return _mm256_cvtps_epi32 (a); }
+    NEURAL_TARGET_AVX2 static V toFloat (I a)            { return _mm256_cvtepi32_ps (a); }
+
+    NEURAL_TARGET_AVX2 static V pow2 (I n)
+    {
+        return _mm256_castsi256_ps (_mm256_slli_epi32 (_mm256_add_epi32 (n, _mm256_set1_epi32 (127)), 23));
+    }
+
+    NEURAL_TARGET_AVX2 static V splitExponent (V x, V& exponent)
+    {
+        auto bits = _mm256_castps_si256 (x);
+        exponent = _mm256_cvtepi32_ps (_mm256_sub_epi32 (_mm256_srli_epi32 (bits, 23), _mm256_set1_epi32 (127)));
+        bits = _mm256_or_si256 (_mm256_and_si256 (bits, _mm256_set1_epi32 (0x007fffff)), _mm256_set1_epi32 (0x3f800000));
+        return _mm256_castsi256_ps (bits);
+    }
+};
+
+//==============================================================================
+struct Avx512Ops
+{
+    using V = __m512;
+    using I = __m512i;
+    static constexpr int width = 16;
+    using Narrower = Avx2Ops;
+
+    NEURAL_TARGET_AVX512 static V load (const float* p)    { return _mm512_loadu_ps (p); }
+    NEURAL_TARGET_AVX512 static void store (float* p, V v) { _mm512_storeu_ps (p, v); }
+    NEURAL_TARGET_AVX512 static V set (float x)            { return _mm512_set1_ps (x); }
+    NEURAL_TARGET_AVX512 static V add (V a, V b)           { return _mm512_add_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V sub (V a, V b)           { return _mm512_sub_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V mul (V a, V b)           { return _mm512_mul_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V div (V a, V b)           { return _mm512_div_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V madd (V a, V b, V c)     { return _mm512_fmadd_ps (a, b, c); }
+    NEURAL_TARGET_AVX512 static V min (V a, V b)           { return _mm512_min_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V max (V a, V b)           { return _mm512_max_ps (a, b); }
+    NEURAL_TARGET_AVX512 static V abs (V a)                { return _mm512_abs_ps (a); }
+
+    NEURAL_TARGET_AVX512 static V copySign (V magnitude, V sign)
+    {
+        auto signBit = _mm512_set1_epi32 ((int) 0x80000000u);
+        return _mm512_castsi512_ps (_mm512_or_si512 (_mm512_andnot_si512 (signBit, _mm512_castps_si512 (magnitude)),
+                                                     _mm512_and_si512 (signBit, _mm512_castps_si512 (sign))));
+    }
+
+    NEURAL_TARGET_AVX512 static V selectGreater (V a, V b, V ifTrue, V ifFalse)
+    {
+        return _mm512_mask_blend_ps (_mm512_cmp_ps_mask (a, b, _CMP_GT_OQ), ifFalse, ifTrue);
+    }
+
+    NEURAL_TARGET_AVX512 static I roundToInt (V a)         { return _mm512_cvtps_epi32 (a); }
+    NEURAL_TARGET_AVX512 static V toFloat (I a)            { return _mm512_cvtepi32_ps (a); }
+
+    NEURAL_TARGET_AVX512 static V pow2 (I n)
+    {
+        return _mm512_castsi512_ps (_mm512_slli_epi32 (_mm512_add_epi32 (n, _mm512_set1_epi32 (127)), 23));
+    }
+
+    NEURAL_TARGET_AVX512 static V splitExponent (V x, V& exponent)
+    {
+        auto bits = _mm512_castps_si512 (x);
+        exponent = _mm512_cvtepi32_ps (_mm512_sub_epi32 (_mm512_srli_epi32 (bits, 23), _mm512_set1_epi32 (127)));
+        bits = _mm512_or_si512 (_mm512_and_si512 (bits, _mm512_set1_epi32 (0x007fffff)), _mm512_set1_epi32 (0x3f800000));
+        return _mm512_castsi512_ps (bits);
+    }
+};
+#endif
+
+//==============================================================================
+#if NEURAL_FASTMATH_AARCH64
+struct NeonOps
+{
+    using V = float32x4_t;
+    using I = int32x4_t;
+    static constexpr int width = 4;
+    using Narrower = ScalarOps;
+
+    static V load (const float* p)              { return vld1q_f32 (p); }
+    static void store (float* p, V v)           { vst1q_f32 (p, v); }
+    static V set (float x)                      { return vdupq_n_f32 (x); }
+    static V add (V a, V b)                     { return vaddq_f32 (a, b); }
+    static V sub (V a, V b)                     { return vsubq_f32 (a, b); }
+    static V mul (V a, V b)                     { return vmulq_f32 (a, b); }
+    static V div (V a, V b)                     { return vdivq_f32 (a, b); }
+    static V madd (V a, V b, V c)               { return vfmaq_f32 (c, a, b); }
+    static V min (V a, V b)                     { return vminq_f32 (a, b); }
+    static V max (V a, V b)                     { return vmaxq_f32 (a, b); }
+    static V abs (V a)                          { return vabsq_f32 (a); }
+
+    static V copySign (V magnitude, V sign)
+    {
+        return vbslq_f32 (vdupq_n_u32 (0x80000000u), sign, magnitude);
+    }
+
+    static V selectGreater (V a, V b, V ifTrue, V ifFalse)
+    {
+        return vbslq_f32 (vcgtq_f32 (a, b), ifTrue, ifFalse);
+    }
+
+    static I roundToInt (V a)                   { return vcvtnq_s32_f32 (a); }
+    static V toFloat (I a)                      { return vcvtq_f32_s32 (a); }
+
+    static V pow2 (I n)
+    {
+        return vreinterpretq_f32_s32 (vshlq_n_s32 (vaddq_s32 (n, vdupq_n_s32 (127)), 23));
+    }
+
+    static V splitExponent (V x, V& exponent)
+    {
+        auto bits = vreinterpretq_u32_f32 (x);
+        exponent = vcvtq_f32_s32 (vsubq_s32 (vreinterpretq_s32_u32 (vshrq_n_u32 (bits, 23)), vdupq_n_s32 (127)));
+        bits = vorrq_u32 (vandq_u32 (bits, vdupq_n_u32 (0x007fffffu)), vdupq_n_u32 (0x3f800000u));
+        return vreinterpretq_f32_u32 (bits);
+    }
+};
+#endif
+
+//==============================================================================
+// What the plain (non-dispatched) entry points run with
+#if defined (__AVX512F__)
+ using NativeOps = Avx512Ops;
+#elif defined (__AVX2__) && defined (__FMA__)
+ using NativeOps = Avx2Ops;
+#elif NEURAL_FASTMATH_X86
+ using NativeOps = Sse2Ops;
+#elif NEURAL_FASTMATH_AARCH64
+ using NativeOps = NeonOps;
+#else
+ using NativeOps = ScalarOps;
+#endif
+
+namespace detail
+{
+
+// The functions below work in place, through a reference, so only the lane
+// operations, which name their target, take or return vectors by value (see
+// the -Wpsabi note at the top)
+
+// Cody-Waite reduction x = n ln2 + r, |r| <= ln2 / 2, then a degree 6 minimax
+// polynomial for exp (r) (Cephes expf)
+template <typename Ops>
+void exp (typename Ops::V& x)
+{
+    x = Ops::min (Ops::max (x, Ops::set (-87.3f)), Ops::set (88.3f));
+
+    auto n = Ops::roundToInt (Ops::mul (x, Ops::set (1.44269504088896341f)));
+    auto fn = Ops::toFloat (n);
+    auto r = Ops::sub (Ops::sub (x, Ops::mul (fn, Ops::set (0.693359375f))), Ops::mul (fn, Ops::set (-2.12194440e-4f)));
+
+    auto p = Ops::set (1.9875691500e-4f);
+    p = Ops::madd (p, r, Ops::set (1.3981999507e-3f));
+    p = Ops::madd (p, r, Ops::set (8.3334519073e-3f));
+    p = Ops::madd (p, r, Ops::set (4.1665795894e-2f));
+    p = Ops::madd (p, r, Ops::set (1.6666665459e-1f));
+    p = Ops::madd (p, r, Ops::set (5.0000001201e-1f));
+    p = Ops::madd (p, Ops::mul (r, r), Ops::add (r, Ops::set (1.0f)));
+
+    x = Ops::mul (p, Ops::pow2 (n));
+}
+
+// log (x) for x >= 1, via mantissa in [sqrt(1/2), sqrt(2)) and a degree 9
+// polynomial (Cephes logf); only used by softplus, where x = 1 + exp (-|y|)
+template <typename Ops>
+void logAboveOne (typename Ops::V& x)
+{
+    typename Ops::V e;
+    auto m = Ops::splitExponent (x, e);
+
+    // Keep the mantissa centred on 1 so the polynomial stays accurate
+    auto big = Ops::selectGreater (m, Ops::set (1.41421356f), Ops::set (1.0f), Ops::set (0.0f));
+    e = Ops::add (e, big);
+    m = Ops::div (m, Ops::add (Ops::set (1.0f), big));
+    auto f = Ops::sub (m, Ops::set (1.0f));
+
+    auto f2 = Ops::mul (f, f);
+    auto p = Ops::set (7.0376836292e-2f);
+    p = Ops::madd (p, f, Ops::set (-1.1514610310e-1f));
+    p = Ops::madd (p, f, Ops::set (1.1676998740e-1f));
+    p = Ops::madd (p, f, Ops::set (-1.2420140846e-1f));
+    p = Ops::madd (p, f, Ops::set (1.4249322787e-1f));
+    p = Ops::madd (p, f, Ops::set (-1.6668057665e-1f));
+    p = Ops::madd (p, f, Ops::set (2.0000714765e-1f));
+    p = Ops::madd (p, f, Ops::set (-2.4999993993e-1f));
+    p = Ops::madd (p, f, Ops::set (3.3333331174e-1f));
+    p = Ops::mul (Ops::mul (p, f), f2);
+    p = Ops::madd (f2, Ops::set (-0.5f), p);
+
+    x = Ops::madd (e, Ops::set (0.693147180559945f), Ops::add (f, p));
+}
+
+template <typename Ops>
+void tanh (typename Ops::V& x)
+{
+    // Small inputs use the odd series directly, where 1 - 2 / (e^2x + 1) would cancel
+    auto a = Ops::min (Ops::abs (x), Ops::set (9.0f));
+    auto e = Ops::mul (a, Ops::set (2.0f));
+    exp<Ops> (e);
+    auto large = Ops::sub (Ops::set (1.0f), Ops::div (Ops::set (2.0f), Ops::add (e, Ops::set (1.0f))));
+
+    auto a2 = Ops::mul (a, a);
+    auto small = Ops::madd (a2, Ops::set (0.0539682540f), Ops::set (-0.1333333333f));
+    small = Ops::madd (small, a2, Ops::set (0.3333333333f));
+    small = Ops::sub (a, Ops::mul (Ops::mul (small, a2), a));
+
+    x = Ops::copySign (Ops::selectGreater (a, Ops::set (0.0625f), large, small), x);
+}
+
+template <typename Ops>
+void sigmoid (typename Ops::V& x)
+{
+    auto e = Ops::sub (Ops::set (0.0f), x);
+    exp<Ops> (e);
+    x = Ops::div (Ops::set (1.0f), Ops::add (Ops::set (1.0f), e));
+}
+
+template <typename Ops>
+void softplus (typename Ops::V& x)
+{
+    // max (x, 0) + log1p (exp (-|x|)) never overflows. log1p (e) is
+    // log (u) * e / (u - 1) with u = 1 + e, which cancels the rounding of u,
+    // and the series e - e^2 / 2 once u gets too close to 1 for the division
+    auto e = Ops::sub (Ops::set (0.0f), Ops::abs (x));
+    exp<Ops> (e);
+    auto u = Ops::add (Ops::set (1.0f), e);
+    auto logU = u;
+    logAboveOne<Ops> (logU);
+    auto series = Ops::mul (e, Ops::madd (e, Ops::set (-0.5f), Ops::set (1.0f)));
+    auto log1p = Ops::selectGreater (e, Ops::set (1.0e-4f),
+                                     Ops::div (Ops::mul (logU, e), Ops::sub (u, Ops::set (1.0f))),
+                                     series);
+    x = Ops::add (Ops::max (x, Ops::set (0.0f)), log1p);
+}
+
+// Abramowitz & Stegun 7.1.26
+template <typename Ops>
+void erf (typename Ops::V& x)
+{
+    auto a = Ops::min (Ops::abs (x), Ops::set (6.0f));
+    auto t = Ops::div (Ops::set (1.0f), Ops::madd (a, Ops::set (0.3275911f), Ops::set (1.0f)));
+
+    auto p = Ops::set (1.061405429f);
+    p = Ops::madd (p, t, Ops::set (-1.453152027f));
+    p = Ops::madd (p, t, Ops::set (1.421413741f));
+    p = Ops::madd (p, t, Ops::set (-0.284496736f));
+    p = Ops::madd (p, t, Ops::set (0.254829592f));
+    p = Ops::mul (p, t);
+
+    auto e = Ops::sub (Ops::set (0.0f), Ops::mul (a, a));
+    exp<Ops> (e);
+    x = Ops::copySign (Ops::sub (Ops::set (1.0f), Ops::mul (p, e)), x);
+}
+
+// Runs fn over a block a register at a time, then hands the remainder to
+// the next narrower lane set until the scalar one finishes it
+template <typename Ops, typename Fn>
+void forEachBlock (const float* in, float* out, int numSamples, const Fn& fn)
+{
+    int i = 0;
+
+    for (; i + Ops::width <= numSamples; i += Ops::width)
+    {
+        auto x = Ops::load (in + i);
+        fn.template apply<Ops> (x);
+        Ops::store (out + i, x);
+    }
+
+    if constexpr (Ops::width > 1)
+        if (i < numSamples)
+            forEachBlock<typename Ops::Narrower> (in + i, out + i, numSamples - i, fn);
+}
+
+#define NEURAL_FASTMATH_FUNCTOR(Name, name) \
+    struct Name \
+    { \
+        template <typename Ops> \
+        void apply (typename Ops::V& x) const { name<Ops> (x); } \
+    };
+
+NEURAL_FASTMATH_FUNCTOR (Exp, exp)
+NEURAL_FASTMATH_FUNCTOR (Tanh, tanh)
+NEURAL_FASTMATH_FUNCTOR (Sigmoid, sigmoid)
+NEURAL_FASTMATH_FUNCTOR (Softplus, softplus)
+NEURAL_FASTMATH_FUNCTOR (Erf, erf)
+
+#undef NEURAL_FASTMATH_FUNCTOR
+
+struct SoftLimit
+{
+    float threshold;
+
+    template <typename Ops>
+    void apply (typename Ops::V& x) const
+    {
+        auto limited = x;
+        tanh<Ops> (limited);
+        x = Ops::selectGreater (Ops::abs (x), Ops::set (threshold), limited, x);
+    }
+};
+
+} // namespace detail
+
+//==============================================================================
+inline float exp (float x)          { detail::exp<ScalarOps> (x); return x; }
+inline float tanh (float x)         { detail::tanh<ScalarOps> (x); return x; }
+inline float sigmoid (float x)      { detail::sigmoid<ScalarOps> (x); return x; }
+inline float softplus (float x)     { detail::softplus<ScalarOps> (x); return x; }
+inline float erf (float x)          { detail::erf<ScalarOps> (x); return x; }
+
+// Block versions; out may alias in
+template <typename Ops = NativeOps>
+void exp (const float* in, float* out, int numSamples)         { detail::forEachBlock<Ops> (in, out, numSamples, detail::Exp {}); }
+
+template <typename Ops = NativeOps>
+void tanh (const float* in, float* out, int numSamples)        { detail::forEachBlock<Ops> (in, out, numSamples, detail::Tanh {}); }
+
+template <typename Ops = NativeOps>
+void sigmoid (const float* in, float* out, int numSamples)     { detail::forEachBlock<Ops> (in, out, numSamples, detail::Sigmoid {}); }
+
+template <typename Ops = NativeOps>
+void softplus (const float* in, float* out, int numSamples)    { detail::forEachBlock<Ops> (in, out, numSamples, detail::Softplus {}); }
+
+template <typename Ops = NativeOps>
+void erf (const float* in, float* out, int numSamples)         { detail::forEachBlock<Ops> (in, out, numSamples, detail::Erf {}); }
+
+// The processors' output limiter: samples beyond threshold in magnitude are
+// replaced by their tanh, the rest pass through untouched; out may alias in
+template <typename Ops = NativeOps>
+void softLimit (const float* in, float* out, int numSamples, float threshold)
+{
+    detail::forEachBlock<Ops> (in, out, numSamples, detail::SoftLimit { threshold });
+}
+
+} // namespace fastmath
+} // namespace neural
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC diagnostic pop
+#endif
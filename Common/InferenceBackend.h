@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    InferenceBackend.h
+
+    Selects which engine a processor uses to run its model.
+
+    Build with NEURAL_USE_ONNXRUNTIME=0 (and without linking onnxruntime) to
+    ship a plugin that only uses the native kernels, and with
+    NEURAL_USE_GENERATED_MODEL=1 to run those kernels on the weights compiled
+    into Source/Generated by Tools/GenerateModelHeader.cpp rather than
+    reading them from the .onnx file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef NEURAL_USE_ONNXRUNTIME
+ #define NEURAL_USE_ONNXRUNTIME 1
+#endif
+
+#ifndef NEURAL_USE_GENERATED_MODEL
+ #define NEURAL_USE_GENERATED_MODEL 0
+#endif
+
+namespace neural
+{
+
+enum class InferenceBackend
+{
+    onnxRuntime,   // Ort::Session::Run on the shipped .onnx file
+    native         // built-in fixed-size kernels fed with the same weights
+};
+
+} // namespace neural
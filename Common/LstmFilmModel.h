@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    LstmFilmModel.h
+
+    Native kernel for the small LSTM models: a single-layer LSTM, FiLM from
+    the conditioning inputs, a softsign gated linear unit and a linear head.
+    The same kernel runs Hybrid's CL1BTapePreamp__lstm_8.onnx and
+    NeuralPiano's UprightPiano.onnx; only the sizes and initializer names
+    differ.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "NeuralLayers.h"
+
+namespace neural
+{
+
+struct LstmFilmWeightNames
+{
+    const char* lstmW;
+    const char* lstmR;
+    const char* lstmB;
+    const char* filmWeight;
+    const char* filmBias;
+    const char* gluWeight;
+    const char* gluBias;
+    const char* headWeight;
+    const char* headBias;
+};
+
+//==============================================================================
+template <int HiddenSize, int NumConditioning, bool GluGateFirstHalf>
+class LstmFilmModel
+{
+public:
+    static constexpr int hiddenSize = HiddenSize;   // floats in each of h and c
+
+    struct Weights
+    {
+        LstmCell<1, HiddenSize> lstm;
+        Dense<NumConditioning, 2 * HiddenSize> film;
+        SoftsignGlu<HiddenSize, GluGateFirstHalf> glu;
+        Dense<HiddenSize, 1> head;
+
+        template <typename Visitor>
+        void visitArrays (Visitor&& visit) const
+        {
+            lstm.visitArrays (visit);
+            film.visitArrays (visit);
+            glu.visitArrays (visit);
+            head.visitArrays (visit);
+        }
+    };
+
+    bool load (const std::string& modelPath, const LstmFilmWeightNames& names)
+    {
+        OnnxInitializers initializers;
+
+        return initializers.loadFromFile (modelPath) && load (initializers, names);
+    }
+
+    bool load (const OnnxInitializers& w, const LstmFilmWeightNames& names)
+    {
+        return weights.lstm.load (w, names.lstmW, names.lstmR, names.lstmB)
+            && weights.film.load (w, names.filmWeight, names.filmBias)
+            && weights.glu.load (w, names.gluWeight, names.gluBias)
+            && weights.head.load (w, names.headWeight, names.headBias);
+    }
+
+    const Weights& getWeights() const   { return weights; }
+
+    // Runs one block for one channel. conditioning holds one per-sample array
+    // per conditioning input, in the order the model concatenates them.
+    // h and c are the [HiddenSize] LSTM states, updated in place; output may
+    // alias input.
+    void process (const float* input, const float* const* conditioning,
+                  float* output, int numSamples, float* h, float* c) const
+    {
+        run (weights, input, conditioning, output, numSamples, h, c);
+    }
+
+    // The same, for weights that do not live in a model object, e.g. the
+    // constexpr ones in a header written by Tools/GenerateModelHeader.cpp.
+    // Ops picks the instruction set (see CpuDispatch.h).
+    template <typename Ops = fastmath::NativeOps>
+    static void run (const Weights& w, const float* input, const float* const* conditioning,
+                     float* output, int numSamples, float* h, float* c)
+    {
+        runInterleaved<1, Ops> (w, &input, conditioning, &output, numSamples, &h, &c);
+    }
+
+    // Runs Channels channels (e.g. left and right) in one pass, their values
+    // interleaved so that every LSTM step advances all of them together.
+    // inputs, outputs, hs and cs hold one pointer per channel, laid out as for
+    // run(); the conditioning is shared. Each channel's result is the same as
+    // running it on its own, to within the rounding of the wider SIMD blocks.
+    template <int Channels, typename Ops = fastmath::NativeOps>
+    static void runInterleaved (const Weights& w, const float* const* inputs, const float* const* conditioning,
+                                float* const* outputs, int numSamples, float* const* hs, float* const* cs)
+    {
+        alignas (32) float h[HiddenSize * Channels], c[HiddenSize * Channels];
+
+        for (int k = 0; k < HiddenSize; ++k)
+        {
+            for (int ch = 0; ch < Channels; ++ch)
+            {
+                h[k * Channels + ch] = hs[ch][k];
+                c[k * Channels + ch] = cs[ch][k];
+            }
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float x[Channels];
+
+            for (int ch = 0; ch < Channels; ++ch)
+                x[ch] = inputs[ch][i];
+
+            w.lstm.template step<Ops, Channels> (x, h, c);
+
+            float cond[NumConditioning];
+
+            for (int k = 0; k < NumConditioning; ++k)
+                cond[k] = conditioning[k][i];
+
+            float filmOut[2 * HiddenSize];
+            w.film.forward (cond, filmOut);
+
+            float modulated[HiddenSize * Channels];
+
+            for (int k = 0; k < HiddenSize; ++k)
+                for (int ch = 0; ch < Channels; ++ch)
+                    modulated[k * Channels + ch] = filmOut[k] * h[k * Channels + ch] + filmOut[HiddenSize + k];
+
+            float gated[HiddenSize * Channels], y[Channels];
+            w.glu.template forward<Channels> (modulated, gated);
+            w.head.template forward<Channels> (gated, y);
+
+            for (int ch = 0; ch < Channels; ++ch)
+                outputs[ch][i] = y[ch];
+        }
+
+        for (int k = 0; k < HiddenSize; ++k)
+        {
+            for (int ch = 0; ch < Channels; ++ch)
+            {
+                hs[ch][k] = h[k * Channels + ch];
+                cs[ch][k] = c[k * Channels + ch];
+            }
+        }
+    }
+
+private:
+    Weights weights;
+};
+
+//==============================================================================
+// Hybrid/Models/CL1BTapePreamp__lstm_8.onnx, conditioned on (c, t, p)
+using TapePreampLstmModel = LstmFilmModel<8, 3, true>;
+
+inline constexpr LstmFilmWeightNames tapePreampLstmWeights
+{
+    "onnx::LSTM_117", "onnx::LSTM_118", "onnx::LSTM_119",
+    "onnx::MatMul_120", "film_layer.bias",
+    "onnx::MatMul_121", "glu.bias",
+    "onnx::MatMul_122", "linear.bias"
+};
+
+// NeuralPiano/Models/UprightPiano.onnx, conditioned on a 2-wide cond input
+using UprightPianoLstmModel = LstmFilmModel<8, 2, false>;
+
+inline constexpr LstmFilmWeightNames uprightPianoLstmWeights
+{
+    "onnx::LSTM_114", "onnx::LSTM_115", "onnx::LSTM_116",
+    "onnx::MatMul_117", "film.bias",
+    "onnx::MatMul_118", "glu.bias",
+    "onnx::MatMul_119", "output_layer.bias"
+};
+
+} // namespace neural
@@ -0,0 +1,723 @@
+/*
+  ==============================================================================
+
+    NeuralLayers.h
+
+    Fixed-size building blocks for running the plugins' models natively,
+    sample by sample, without going through ONNX Runtime. All sizes are
+    template parameters so the compiler can unroll the small loops, and no
+    layer allocates after its weights have been loaded.
+
+    Every initializer is checked against the shape the layer expects when it
+    is loaded. MatMul weights keep their ONNX [in][out] layout; the recurrent
+    cells repack their [gates * hidden][in] matrices to [in][gates * hidden]
+    so each step is a run of contiguous, 32-byte aligned multiply-adds across
+    all gates at once.
+
+    Every layer is a plain aggregate of float arrays. visitArrays() walks them
+    in declaration order, which is what Tools/GenerateModelHeader.cpp uses to
+    bake loaded weights into a constexpr initializer.
+
+    The activations come from FastMath.h; where a layer applies one to a whole
+    vector (gates, scan decays) it uses the block versions, so they run a SIMD
+    register at a time. Those steps take the fastmath lane operations as a
+    template argument (defaulting to the build's own), so that CpuDispatch.h
+    can compile a whole model once per instruction set.
+
+    The forward passes and steps also take a channel count (default 1). With
+    more than one, every vector holds that many independent streams
+    interleaved element by element ([n][Channels]), so a step advances all of
+    them in one pass with the same arithmetic per stream. That is what lets the
+    plugins run stereo through models whose hidden sizes alone would leave most
+    of a SIMD register empty.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include "FastMath.h"
+#include "OnnxInitializers.h"
+
+namespace neural
+{
+
+//==============================================================================
+inline float sigmoid (float x)     { return fastmath::sigmoid (x); }
+inline float silu (float x)        { return x * sigmoid (x); }
+inline float softsign (float x)    { return x / (std::abs (x) + 1.0f); }
+inline float gelu (float x)        { return 0.5f * x * (1.0f + fastmath::erf (x * 0.70710678118654752f)); }
+inline float softplus (float x)    { return fastmath::softplus (x); }
+
+// In place over a vector
+template <int Size, typename Ops = fastmath::NativeOps>
+void gelu (float* x)
+{
+    alignas (32) float e[Size];
+
+    for (int i = 0; i < Size; ++i)
+        e[i] = x[i] * 0.70710678118654752f;
+
+    fastmath::erf<Ops> (e, e, Size);
+
+    for (int i = 0; i < Size; ++i)
+        x[i] = 0.5f * x[i] * (1.0f + e[i]);
+}
+
+//==============================================================================
+/** y = x * W (+ b), with W stored [In][Out] as exported by the MatMul nodes. */
+template <int In, int Out, bool HasBias = true>
+struct Dense
+{
+    alignas (32) float weight[In][Out] {};
+    alignas (32) float bias[Out] {};
+
+    bool load (const OnnxInitializers& w, const char* weightName, const char* biasName = nullptr)
+    {
+        if (! w.copyTo (weightName, &weight[0][0], { In, Out }))
+            return false;
+
+        return ! HasBias || w.copyTo (biasName, bias, { Out });
+    }
+
+    template <typename Visitor>
+    void visitArrays (Visitor&& visit) const
+    {
+        visit (&weight[0][0], In * Out);
+        visit (bias, Out);
+    }
+
+    template <int Channels = 1>
+    void forward (const float* x, float* y) const
+    {
+        for (int o = 0; o < Out; ++o)
+            for (int ch = 0; ch < Channels; ++ch)
+                y[o * Channels + ch] = bias[o];
+
+        for (int i = 0; i < In; ++i)
+            for (int o = 0; o < Out; ++o)
+                for (int ch = 0; ch < Channels; ++ch)
+                    y[o * Channels + ch] += x[i * Channels + ch] * weight[i][o];
+    }
+};
+
+//==============================================================================
+/** FiLM-style gated linear unit used after each conditioning stage: the dense
+    output is split in two halves and one half is gated by softsign of the other.
+*/
+template <int Size, bool GateFirstHalf = false>
+struct SoftsignGlu
+{
+    Dense<Size, 2 * Size> dense;
+
+    bool load (const OnnxInitializers& w, const char* weightName, const char* biasName)
+    {
+        return dense.load (w, weightName, biasName);
+    }
+
+    template <typename Visitor>
+    void visitArrays (Visitor&& visit) const
+    {
+        dense.visitArrays (visit);
+    }
+
+    template <int Channels = 1>
+    void forward (const float* x, float* y) const
+    {
+        float projected[2 * Size * Channels];
+        dense.template forward<Channels> (x, projected);
+
+        const float* first = projected;
+        const float* second = projected + Size * Channels;
+
+        for (int i = 0; i < Size * Channels; ++i)
+            y[i] = GateFirstHalf ? second[i] * softsign (first[i])
+                                 : first[i] * softsign (second[i]);
+    }
+};
+
+//==============================================================================
+/** ONNX GRU cell (gate order z, r, h) with linear_before_reset = 1. */
+template <int In, int Hidden>
+struct GruCell
+{
+    alignas (32) float W[In][3 * Hidden] {};       // transposed from the ONNX layout
+    alignas (32) float R[Hidden][3 * Hidden] {};
+    alignas (32) float Wb[3 * Hidden] {};
+    alignas (32) float Rb[3 * Hidden] {};
+
+    bool load (const OnnxInitializers& w, const char* wName, const char* rName, const char* bName)
+    {
+        float wOnnx[3 * Hidden][In], rOnnx[3 * Hidden][Hidden], b[6 * Hidden];
+
+        if (! (w.copyTo (wName, &wOnnx[0][0], { 1, 3 * Hidden, In })
+               && w.copyTo (rName, &rOnnx[0][0], { 1, 3 * Hidden, Hidden })
+               && w.copyTo (bName, b, { 1, 6 * Hidden })))
+            return false;
+
+        for (int g = 0; g < 3 * Hidden; ++g)
+        {
+            for (int i = 0; i < In; ++i)
+                W[i][g] = wOnnx[g][i];
+
+            for (int i = 0; i < Hidden; ++i)
+                R[i][g] = rOnnx[g][i];
+        }
+
+        std::copy (b, b + 3 * Hidden, Wb);
+        std::copy (b + 3 * Hidden, b + 6 * Hidden, Rb);
+        return true;
+    }
+
+    template <typename Visitor>
+    void visitArrays (Visitor&& visit) const
+    {
+        visit (&W[0][0], In * 3 * Hidden);
+        visit (&R[0][0], Hidden * 3 * Hidden);
+        visit (Wb, 3 * Hidden);
+        visit (Rb, 3 * Hidden);
+    }
+
+    template <typename Ops = fastmath::NativeOps, int Channels = 1>
+    void step (const float* x, float* h) const
+    {
+        constexpr int width = Hidden * Channels;    // one gate, all channels
+
+        alignas (32) float xw[3 * width], hr[3 * width];
+
+        for (int g = 0; g < 3 * Hidden; ++g)
+        {
+            for (int ch = 0; ch < Channels; ++ch)
+            {
+                xw[g * Channels + ch] = Wb[g];
+                hr[g * Channels + ch] = Rb[g];
+            }
+        }
+
+        for (int i = 0; i < In; ++i)
+            for (int g = 0; g < 3 * Hidden; ++g)
+                for (int ch = 0; ch < Channels; ++ch)
+                    xw[g * Channels + ch] += W[i][g] * x[i * Channels + ch];
+
+        for (int i = 0; i < Hidden; ++i)
+            for (int g = 0; g < 3 * Hidden; ++g)
+                for (int ch = 0; ch < Channels; ++ch)
+                    hr[g * Channels + ch] += R[i][g] * h[i * Channels + ch];
+
+        // z and r are adjacent, so both gates go through one sigmoid pass
+        alignas (32) float zr[2 * width], candidate[width];
+
+        for (int g = 0; g < 2 * width; ++g)
+            zr[g] = xw[g] + hr[g];
+
+        fastmath::sigmoid<Ops> (zr, zr, 2 * width);
+
+        for (int i = 0; i < width; ++i)
+            candidate[i] = xw[2 * width + i] + zr[width + i] * hr[2 * width + i];
+
+        fastmath::tanh<Ops> (candidate, candidate, width);
+
+        for (int i = 0; i < width; ++i)
+            h[i] = (1.0f - zr[i]) * candidate[i] + zr[i] * h[i];
+    }
+};
+
+//==============================================================================
+/** ONNX LSTM cell (gate order i, o, f, c) without peepholes. */
+template <int In, int Hidden>
+struct LstmCell
+{
+    alignas (32) float W[In][4 * Hidden] {};       // transposed from the ONNX layout
+    alignas (32) float R[Hidden][4 * Hidden] {};
+    alignas (32) float bias[4 * Hidden] {};        // input and recurrent biases folded together
+
+    bool load (const OnnxInitializers& w, const char* wName, const char* rName, const char* bName)
+    {
+        float wOnnx[4 * Hidden][In], rOnnx[4 * Hidden][Hidden], b[8 * Hidden];
+
+        if (! (w.copyTo (wName, &wOnnx[0][0], { 1, 4 * Hidden, In })
+               && w.copyTo (rName, &rOnnx[0][0], { 1, 4 * Hidden, Hidden })
+               && w.copyTo (bName, b, { 1, 8 * Hidden })))
+            return false;
+
+        for (int g = 0; g < 4 * Hidden; ++g)
+        {
+            for (int i = 0; i < In; ++i)
+                W[i][g] = wOnnx[g][i];
+
+            for (int i = 0; i < Hidden; ++i)
+                R[i][g] = rOnnx[g][i];
+
+            bias[g] = b[g] + b[4 * Hidden + g];
+        }
+
+        return true;
+    }
+
+    template <typename Visitor>
+    void visitArrays (Visitor&& visit) const
+    {
+        visit (&W[0][0], In * 4 * Hidden);
+        visit (&R[0][0], Hidden * 4 * Hidden);
+        visit (bias, 4 * Hidden);
+    }
+
+    template <typename Ops = fastmath::NativeOps, int Channels = 1>
+    void step (const float* x, float* h, float* c) const
+    {
+        constexpr int width = Hidden * Channels;    // one gate, all channels
+
+        alignas (32) float gates[4 * width];
+
+        for (int g = 0; g < 4 * Hidden; ++g)
+            for (int ch = 0; ch < Channels; ++ch)
+                gates[g * Channels + ch] = bias[g];
+
+        for (int i = 0; i < In; ++i)
+            for (int g = 0; g < 4 * Hidden; ++g)
+                for (int ch = 0; ch < Channels; ++ch)
+                    gates[g * Channels + ch] += W[i][g] * x[i * Channels + ch];
+
+        for (int i = 0; i < Hidden; ++i)
+            for (int g = 0; g < 4 * Hidden; ++g)
+                for (int ch = 0; ch < Channels; ++ch)
+                    gates[g * Channels + ch] += R[i][g] * h[i * Channels + ch];
+
+        // i, o, f are sigmoids and c is a tanh, each over a contiguous run
+        fastmath::sigmoid<Ops> (gates, gates, 3 * width);
+        fastmath::tanh<Ops> (gates + 3 * width, gates + 3 * width, width);
+
+        const float* inputGate  = gates;
+        const float* outputGate = gates + width;
+        const float* forgetGate = gates + 2 * width;
+        const float* candidate  = gates + 3 * width;
+
+        alignas (32) float cellOut[width];
+
+        for (int i = 0; i < width; ++i)
+            cellOut[i] = c[i] = forgetGate[i] * c[i] + inputGate[i] * candidate[i];
+
+        fastmath::tanh<Ops> (cellOut, cellOut, width);
+
+        for (int i = 0; i < width; ++i)
+            h[i] = outputGate[i] * cellOut[i];
+    }
+};
+
+//==============================================================================
+/**
+    Mamba-style selective state-space block (in projection, depthwise causal
+    conv, SiLU, input-dependent discretisation, scan, SiLU gate, out projection).
+
+    The ONNX export evaluates the scan for a whole block at once with
+    CumSum/Exp/Div, materialising several [samples][inner][state] tensors:
+    with S the running sum of dt * A from the block's second sample on,
+
+        h[t] = exp (S[t]) * sum over s <= t of dt * u * B[s] / (exp (S[s]) + 1e-12)
+             + exp (dt * A[0] + S[t]) * h0
+
+    Here the same sums are advanced one sample at a time, so the state never
+    leaves L1. They restart on every call, like the graph's on every Run,
+    and keep its 1e-12 guard: once exp (S) nears it (a few samples for the
+    piano's fastest states, a few dozen for CL1B) the graph drops new
+    contributions and its output depends on the block size, and so does
+    this. Without the guard the sums are the recurrence
+    h = exp (dt * A) * h + dt * u * B.
+*/
+template <int ModelSize, int InnerSize, int StateSize, int ConvKernelSize, int DtRank = 1>
+struct SelectiveScanBlock
+{
+    static constexpr int historySize = ConvKernelSize > 1 ? ConvKernelSize - 1 : 1;
+
+    // Everything the single [StateSize] vector exchanged with the exported graphs
+    // leaves out, for callers that want block-size independent streaming: the
+    // conv history, laid out [InnerSize][ConvKernelSize - 1] like the conv_history
+    // inputs added by Tools/expose_conv_history.py, then the scan rows of inner
+    // channels 1 and up.
+    static constexpr int convHistorySize = InnerSize * (ConvKernelSize - 1);
+    static constexpr int streamStateSize = convHistorySize + (InnerSize - 1) * StateSize;
+
+    static constexpr int modelSize = ModelSize;             // floats per input / output row
+    static constexpr int scanStateSize = InnerSize * StateSize;
+
+    static constexpr float guard = 1.0e-12f;               // the export's epsilon
+
+    // The state of Channels streams, interleaved like the step() vectors
+    template <int Channels>
+    struct PackedState
+    {
+        alignas (32) float h[InnerSize][StateSize * Channels] {};
+        float convHistory[InnerSize][historySize * Channels] {};   // oldest sample first
+
+        // The current call's sums (see beginCall()): the h0 term's factor
+        // exp (dt * A[0]) * h0, S, and the guarded sum of the inputs
+        alignas (32) float start[InnerSize][StateSize * Channels] {};
+        alignas (32) float logDecay[InnerSize][StateSize * Channels] {};
+        alignas (32) float guardedSum[InnerSize][StateSize * Channels] {};
+        bool callStarted = false;
+    };
+
+    using State = PackedState<1>;
+
+    struct WeightNames
+    {
+        const char* inProjection;
+        const char* convWeight;
+        const char* convBias;
+        const char* aLog;
+        const char* d;
+        const char* xProjection;
+        const char* dtWeight;
+        const char* dtBias;
+        const char* outWeight;
+        const char* outBias;
+    };
+
+    Dense<ModelSize, 2 * InnerSize, false> inProjection;
+    float convWeight[InnerSize][ConvKernelSize] {};
+    float convBias[InnerSize] {};
+    alignas (32) float A[InnerSize][StateSize] {};
+    float D[InnerSize] {};
+    Dense<InnerSize, DtRank + 2 * StateSize, false> xProjection;
+    Dense<DtRank, InnerSize> dtProjection;
+    Dense<InnerSize, ModelSize> outProjection;
+
+    bool load (const OnnxInitializers& w, const WeightNames& names)
+    {
+        if (! (inProjection.load (w, names.inProjection)
+               && w.copyTo (names.convWeight, &convWeight[0][0], { InnerSize, 1, ConvKernelSize })
+               && w.copyTo (names.convBias, convBias, { InnerSize })
+               && w.copyTo (names.aLog, &A[0][0], { InnerSize, StateSize })
+               && w.copyTo (names.d, D, { InnerSize })
+               && xProjection.load (w, names.xProjection)
+               && dtProjection.load (w, names.dtWeight, names.dtBias)
+               && outProjection.load (w, names.outWeight, names.outBias)))
+            return false;
+
+        // The model stores log (-A)
+        for (auto& row : A)
+            for (auto& a : row)
+                a = -std::exp (a);
+
+        return true;
+    }
+
+    template <typename Visitor>
+    void visitArrays (Visitor&& visit) const
+    {
+        inProjection.visitArrays (visit);
+        visit (&convWeight[0][0], InnerSize * ConvKernelSize);
+        visit (convBias, InnerSize);
+        visit (&A[0][0], InnerSize * StateSize);
+        visit (D, InnerSize);
+        xProjection.visitArrays (visit);
+        dtProjection.visitArrays (visit);
+        outProjection.visitArrays (visit);
+    }
+
+    template <typename Ops = fastmath::NativeOps, int Channels = 1>
+    void step (const float* x, float* y, PackedState<Channels>& state) const
+    {
+        float projected[2 * InnerSize * Channels], u[InnerSize * Channels];
+        float xp[(DtRank + 2 * StateSize) * Channels], delta[InnerSize * Channels];
+        discretise<Channels> (x, state, projected, u, xp, delta);
+
+        const float* res = projected + InnerSize * Channels;
+        const float* B = xp + DtRank * Channels;
+        const float* C = xp + (DtRank + StateSize) * Channels;
+
+        float scanned[InnerSize * Channels];
+
+        for (int d = 0; d < InnerSize; ++d)
+        {
+            const float* ud = u + d * Channels;
+            float du[Channels], acc[Channels];
+
+            for (int ch = 0; ch < Channels; ++ch)
+                du[ch] = delta[d * Channels + ch] * ud[ch];
+
+            scanChannel<Ops, Channels> (delta + d * Channels, du, A[d], B, C, state, d, acc);
+
+            for (int ch = 0; ch < Channels; ++ch)
+                scanned[d * Channels + ch] = (acc[ch] + ud[ch] * D[d]) * silu (res[d * Channels + ch]);
+        }
+
+        state.callStarted = true;
+        outProjection.template forward<Channels> (scanned, y);
+    }
+
+    // Restarts the sums from the state in h, as the exported graphs do at the
+    // start of every Run. loadCarriedState() calls it.
+    template <int Channels>
+    static void beginCall (PackedState<Channels>& state)
+    {
+        std::copy (&state.h[0][0], &state.h[0][0] + scanStateSize * Channels, &state.start[0][0]);
+        std::fill (&state.logDecay[0][0], &state.logDecay[0][0] + scanStateSize * Channels, 0.0f);
+        std::fill (&state.guardedSum[0][0], &state.guardedSum[0][0] + scanStateSize * Channels, 0.0f);
+        state.callStarted = false;
+    }
+
+    // Everything up to the scan: the in projection (xs, then the gate's res),
+    // the convolution and SiLU (u), the x projection (dt, B, C) and the
+    // softplus step sizes
+    template <int Channels>
+    void discretise (const float* x, PackedState<Channels>& state,
+                     float* projected, float* u, float* xp, float* delta) const
+    {
+        inProjection.template forward<Channels> (x, projected);
+
+        const float* xs = projected;
+
+        // Depthwise causal convolution, the newest sample meets the last tap
+
+        for (int d = 0; d < InnerSize; ++d)
+        {
+            float* history = state.convHistory[d];
+
+            for (int ch = 0; ch < Channels; ++ch)
+            {
+                const auto newest = xs[d * Channels + ch];
+                auto acc = convBias[d] + convWeight[d][ConvKernelSize - 1] * newest;
+
+                for (int k = 0; k < ConvKernelSize - 1; ++k)
+                    acc += convWeight[d][k] * history[k * Channels + ch];
+
+                for (int k = 0; k < ConvKernelSize - 2; ++k)
+                    history[k * Channels + ch] = history[(k + 1) * Channels + ch];
+
+                if constexpr (ConvKernelSize > 1)
+                    history[(historySize - 1) * Channels + ch] = newest;
+
+                u[d * Channels + ch] = silu (acc);
+            }
+        }
+
+        xProjection.template forward<Channels> (u, xp);
+
+        float dt[InnerSize * Channels];
+        dtProjection.template forward<Channels> (xp, dt);
+
+        for (int i = 0; i < InnerSize * Channels; ++i)
+            delta[i] = softplus (dt[i]);
+    }
+
+    // Advances inner channel d's sums and state and writes its C readout, per
+    // stream. The first sample of a call only folds its decay into the h0
+    // term; S starts from the second, as in the graph. The state is walked in
+    // independent lanes so that wide states (the piano's 64) vectorise,
+    // reduction included, without relying on fast-math; each stream is
+    // summed in the same order whatever Channels is.
+    template <typename Ops = fastmath::NativeOps, int Channels = 1>
+    static void scanChannel (const float* delta, const float* du, const float* a,
+                             const float* B, const float* C, PackedState<Channels>& state, int d, float* readout)
+    {
+        constexpr int lanes = (Ops::width == 16 && StateSize % 16 == 0) ? 16
+                            : (StateSize % 8 == 0 ? 8 : (StateSize % 4 == 0 ? 4 : 1));
+
+        float* h = state.h[d];
+        float* start = state.start[d];
+        float* logDecay = state.logDecay[d];
+        float* guardedSum = state.guardedSum[d];
+
+        alignas (32) float decay[StateSize * Channels];
+
+        for (int n = 0; n < StateSize; ++n)
+            for (int ch = 0; ch < Channels; ++ch)
+                decay[n * Channels + ch] = delta[ch] * a[n];
+
+        if (state.callStarted)
+            for (int i = 0; i < StateSize * Channels; ++i)
+                decay[i] = logDecay[i] += decay[i];
+
+        fastmath::exp<Ops> (decay, decay, StateSize * Channels);
+
+        if (! state.callStarted)
+        {
+            for (int i = 0; i < StateSize * Channels; ++i)
+            {
+                start[i] *= decay[i];
+                decay[i] = 1.0f;
+            }
+        }
+
+        float partial[lanes * Channels] {};
+
+        for (int n = 0; n < StateSize * Channels; n += lanes * Channels)
+        {
+            for (int l = 0; l < lanes * Channels; ++l)
+            {
+                guardedSum[n + l] += du[l % Channels] * B[n + l] / (decay[n + l] + guard);
+                auto next = decay[n + l] * guardedSum[n + l] + decay[n + l] * start[n + l];
+                h[n + l] = next;
+                partial[l] += next * C[n + l];
+            }
+        }
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            auto acc = 0.0f;
+
+            for (int l = 0; l < lanes; ++l)
+                acc += partial[l * Channels + ch];
+
+            readout[ch] = acc;
+        }
+    }
+
+    //==============================================================================
+    // For scanning one long sequence on several threads (see ParallelScan.h).
+    // Once the inputs are known both sums add up segment by segment: S over a
+    // segment is the sum of its own dt * A, and its guarded sum is its own
+    // inputs' once it starts from the right S.
+
+    // Sets the conv history of a segment that starts at input row x from the
+    // historySize rows before it ([ModelSize] each), as step() would have left it
+    void seedConvHistory (const float* x, State& state) const
+    {
+        if constexpr (ConvKernelSize > 1)
+        {
+            for (int k = 0; k < historySize; ++k)
+            {
+                float projected[2 * InnerSize];
+                inProjection.forward (x - (historySize - k) * ModelSize, projected);
+
+                for (int d = 0; d < InnerSize; ++d)
+                    state.convHistory[d][k] = projected[d];
+            }
+        }
+    }
+
+    // Advances the sums over numSamples input rows like step(), without
+    // computing any output
+    template <typename Ops = fastmath::NativeOps>
+    void propagate (const float* x, int numSamples, State& state) const
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float projected[2 * InnerSize], u[InnerSize], xp[DtRank + 2 * StateSize], delta[InnerSize];
+            discretise<1> (x + i * ModelSize, state, projected, u, xp, delta);
+
+            const float* B = xp + DtRank;
+            const float* C = xp + DtRank + StateSize;
+
+            for (int d = 0; d < InnerSize; ++d)
+            {
+                const auto du = delta[d] * u[d];
+                float readout;
+                scanChannel<Ops> (delta + d, &du, A[d], B, C, state, d, &readout);
+            }
+
+            state.callStarted = true;
+        }
+    }
+
+    // The sums a segment starts with, from those the one before it started
+    // with (previous) and what propagate() added over it from zero (local):
+    // chainLogDecay() for S, then, once propagate() has been run again from
+    // that S, chainGuardedSum(). The conv history is left alone.
+    static void chainLogDecay (const State& previous, const State& local, State& next)
+    {
+        const auto& start = previous.callStarted ? previous.start : local.start;
+        std::copy (&start[0][0], &start[0][0] + scanStateSize, &next.start[0][0]);
+
+        for (int d = 0; d < InnerSize; ++d)
+            for (int n = 0; n < StateSize; ++n)
+                next.logDecay[d][n] = previous.logDecay[d][n] + local.logDecay[d][n];
+
+        std::fill (&next.guardedSum[0][0], &next.guardedSum[0][0] + scanStateSize, 0.0f);
+        next.callStarted = true;
+    }
+
+    static void chainGuardedSum (const State& previous, const State& local, State& next)
+    {
+        for (int d = 0; d < InnerSize; ++d)
+            for (int n = 0; n < StateSize; ++n)
+                next.guardedSum[d][n] = previous.guardedSum[d][n] + local.guardedSum[d][n];
+    }
+
+    // The exported graphs carry a single [StateSize] vector between calls: it is
+    // broadcast across the inner channels on the way in, and the caller keeps the
+    // first channel's row of the returned [InnerSize][StateSize] state, while the
+    // convolution restarts from zeros. Passing a [streamStateSize] stream buffer
+    // carries the rest of the state too. Either way the call's sums restart.
+    static void loadCarriedState (State& state, const float* carried, const float* stream = nullptr)
+    {
+        std::copy (carried, carried + StateSize, state.h[0]);
+
+        if (stream == nullptr)
+        {
+            for (int d = 1; d < InnerSize; ++d)
+                std::copy (carried, carried + StateSize, state.h[d]);
+
+            for (auto& row : state.convHistory)
+                std::fill (std::begin (row), std::end (row), 0.0f);
+        }
+        else
+        {
+            if constexpr (ConvKernelSize > 1)
+                std::copy (stream, stream + convHistorySize, &state.convHistory[0][0]);
+
+            std::copy (stream + convHistorySize, stream + streamStateSize, state.h[1]);
+        }
+
+        beginCall (state);
+    }
+
+    static void storeCarriedState (const State& state, float* carried, float* stream = nullptr)
+    {
+        std::copy (state.h[0], state.h[0] + StateSize, carried);
+
+        if (stream == nullptr)
+            return;
+
+        if constexpr (ConvKernelSize > 1)
+            std::copy (&state.convHistory[0][0], &state.convHistory[0][0] + convHistorySize, stream);
+
+        std::copy (state.h[1], state.h[0] + InnerSize * StateSize, stream + convHistorySize);
+    }
+
+    // The same for Channels streams at once, one carried / stream pointer each
+    template <int Channels>
+    static void loadCarriedStates (PackedState<Channels>& state, float* const* carried, float* const* stream = nullptr)
+    {
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            State single;
+            loadCarriedState (single, carried[ch], stream != nullptr ? stream[ch] : nullptr);
+
+            for (int d = 0; d < InnerSize; ++d)
+            {
+                for (int n = 0; n < StateSize; ++n)
+                    state.h[d][n * Channels + ch] = single.h[d][n];
+
+                for (int k = 0; k < historySize; ++k)
+                    state.convHistory[d][k * Channels + ch] = single.convHistory[d][k];
+            }
+        }
+
+        beginCall (state);
+    }
+
+    template <int Channels>
+    static void storeCarriedStates (const PackedState<Channels>& state, float* const* carried, float* const* stream = nullptr)
+    {
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            State single;
+
+            for (int d = 0; d < InnerSize; ++d)
+            {
+                for (int n = 0; n < StateSize; ++n)
+                    single.h[d][n] = state.h[d][n * Channels + ch];
+
+                for (int k = 0; k < historySize; ++k)
+                    single.convHistory[d][k] = state.convHistory[d][k * Channels + ch];
+            }
+
+            storeCarriedState (single, carried[ch], stream != nullptr ? stream[ch] : nullptr);
+        }
+    }
+};
+
+} // namespace neural
@@ -0,0 +1,334 @@
+/*
+  ==============================================================================
+
+    OnnxInitializers.h
+
+    Minimal, dependency-free reader for the float initializers (weights and
+    biases) stored inside an .onnx file or an in-memory copy of one (e.g.
+    BinaryData), so the native inference paths can be fed from the same
+    model files that ONNX Runtime loads, or without ONNX Runtime at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+struct OnnxTensor
+{
+    std::string name;
+    std::vector<int64_t> shape;
+    std::vector<float> data;
+};
+
+//==============================================================================
+/**
+    Pulls the named float initializers out of an ONNX ModelProto.
+
+    Only the handful of protobuf fields needed to reach the graph initializers
+    are decoded; everything else (nodes, value infos, metadata) is skipped.
+*/
+class OnnxInitializers
+{
+public:
+    bool loadFromFile (const std::string& path)
+    {
+        std::ifstream file (path, std::ios::binary | std::ios::ate);
+
+        if (! file)
+            return fail ("cannot open " + path);
+
+        std::vector<char> bytes ((size_t) file.tellg());
+        file.seekg (0);
+
+        if (! file.read (bytes.data(), (std::streamsize) bytes.size()))
+            return fail ("cannot read " + path);
+
+        return loadFromData (bytes.data(), bytes.size());
+    }
+
+    bool loadFromData (const void* data, size_t size)
+    {
+        tensors.clear();
+        lastError.clear();
+
+        Reader model { static_cast<const uint8_t*> (data), static_cast<const uint8_t*> (data) + size };
+
+        while (! model.atEnd())
+        {
+            Field field;
+
+            if (! model.next (field))
+                return fail ("malformed ModelProto");
+
+            if (field.number == modelGraphField && field.wireType == lengthDelimited)
+                if (! readGraph (field.payload))
+                    return fail ("malformed initializer in graph");
+        }
+
+        return ! tensors.empty() || fail ("no float initializers found");
+    }
+
+    const OnnxTensor* find (const std::string& name) const
+    {
+        for (auto& tensor : tensors)
+            if (tensor.name == name)
+                return &tensor;
+
+        return nullptr;
+    }
+
+    // Copies an initializer into a fixed-size destination, failing unless it
+    // has exactly the shape the caller's architecture expects.
+    bool copyTo (const std::string& name, float* dest, std::initializer_list<int64_t> expectedShape) const
+    {
+        auto* tensor = find (name);
+
+        if (tensor == nullptr)
+            return fail ("missing initializer " + name);
+
+        if (! std::equal (tensor->shape.begin(), tensor->shape.end(), expectedShape.begin(), expectedShape.end()))
+            return fail (name + " has shape " + describeShape (tensor->shape.begin(), tensor->shape.end())
+                           + ", expected " + describeShape (expectedShape.begin(), expectedShape.end()));
+
+        std::copy (tensor->data.begin(), tensor->data.end(), dest);
+        return true;
+    }
+
+    const std::vector<OnnxTensor>& getTensors() const   { return tensors; }
+
+    // Why the last load or copyTo failed, for logging
+    const std::string& getLastError() const             { return lastError; }
+
+private:
+    //==============================================================================
+    enum WireType { varint = 0, fixed64 = 1, lengthDelimited = 2, fixed32 = 5 };
+
+    static constexpr uint64_t modelGraphField      = 7;  // ModelProto.graph
+    static constexpr uint64_t graphInitializerField = 5;  // GraphProto.initializer
+    static constexpr uint64_t tensorDimsField      = 1;  // TensorProto.dims
+    static constexpr uint64_t tensorDataTypeField  = 2;  // TensorProto.data_type
+    static constexpr uint64_t tensorFloatDataField = 4;  // TensorProto.float_data
+    static constexpr uint64_t tensorNameField      = 8;  // TensorProto.name
+    static constexpr uint64_t tensorRawDataField   = 9;  // TensorProto.raw_data
+    static constexpr uint64_t floatDataType        = 1;  // TensorProto.DataType.FLOAT
+
+    struct Field;
+
+    struct Reader
+    {
+        const uint8_t* pos;
+        const uint8_t* end;
+
+        bool atEnd() const  { return pos >= end; }
+
+        bool readVarint (uint64_t& value)
+        {
+            value = 0;
+
+            for (int shift = 0; shift < 64 && pos < end; shift += 7)
+            {
+                auto byte = *pos++;
+                value |= (uint64_t) (byte & 0x7f) << shift;
+
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool next (Field& field);
+    };
+
+    struct Field
+    {
+        uint64_t number = 0;
+        int wireType = 0;
+        uint64_t value = 0;
+        Reader payload { nullptr, nullptr };
+    };
+
+    bool readGraph (Reader graph)
+    {
+        while (! graph.atEnd())
+        {
+            Field field;
+
+            if (! graph.next (field))
+                return false;
+
+            if (field.number == graphInitializerField && field.wireType == lengthDelimited)
+                if (! readTensor (field.payload))
+                    return false;
+        }
+
+        return true;
+    }
+
+    bool readTensor (Reader reader)
+    {
+        OnnxTensor tensor;
+        uint64_t dataType = 0;
+        Reader rawData { nullptr, nullptr };
+
+        while (! reader.atEnd())
+        {
+            Field field;
+
+            if (! reader.next (field))
+                return false;
+
+            switch (field.number)
+            {
+                case tensorDimsField:
+                    if (field.wireType == varint)
+                    {
+                        tensor.shape.push_back ((int64_t) field.value);
+                    }
+                    else
+                    {
+                        for (uint64_t dim; ! field.payload.atEnd();)
+                        {
+                            if (! field.payload.readVarint (dim))
+                                return false;
+
+                            tensor.shape.push_back ((int64_t) dim);
+                        }
+                    }
+                    break;
+
+                case tensorDataTypeField:
+                    dataType = field.value;
+                    break;
+
+                case tensorNameField:
+                    tensor.name.assign (reinterpret_cast<const char*> (field.payload.pos),
+                                        (size_t) (field.payload.end - field.payload.pos));
+                    break;
+
+                case tensorRawDataField:
+                    rawData = field.payload;
+                    break;
+
+                case tensorFloatDataField:
+                    if (field.wireType == fixed32)
+                        appendFloats (tensor.data, reinterpret_cast<const uint8_t*> (&field.value), 4);
+                    else
+                        appendFloats (tensor.data, field.payload.pos, (size_t) (field.payload.end - field.payload.pos));
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Integer initializers (shapes, indices) are not needed by the native kernels
+        if (dataType != floatDataType)
+            return true;
+
+        if (rawData.pos != nullptr)
+            appendFloats (tensor.data, rawData.pos, (size_t) (rawData.end - rawData.pos));
+
+        size_t expected = 1;
+
+        for (auto dim : tensor.shape)
+            expected *= (size_t) dim;
+
+        if (expected != tensor.data.size())
+            return false;
+
+        tensors.push_back (std::move (tensor));
+        return true;
+    }
+
+    // ONNX stores tensor data little-endian, which matches every platform we ship on
+    static void appendFloats (std::vector<float>& dest, const uint8_t* src, size_t numBytes)
+    {
+        auto offset = dest.size();
+        dest.resize (offset + numBytes / sizeof (float));
+        std::memcpy (dest.data() + offset, src, (numBytes / sizeof (float)) * sizeof (float));
+    }
+
+    bool fail (const std::string& message) const
+    {
+        lastError = message;
+        return false;
+    }
+
+    template <typename Iterator>
+    static std::string describeShape (Iterator begin, Iterator end)
+    {
+        std::string result = "[";
+
+        for (auto it = begin; it != end; ++it)
+            result += (it == begin ? "" : ", ") + std::to_string (*it);
+
+        return result + "]";
+    }
+
+    std::vector<OnnxTensor> tensors;
+    mutable std::string lastError;
+};
+
+inline bool OnnxInitializers::Reader::next (Field& field)
+{
+    uint64_t key;
+
+    if (! readVarint (key))
+        return false;
+
+    field.number = key >> 3;
+    field.wireType = (int) (key & 7);
+
+    switch (field.wireType)
+    {
+        case varint:
+            return readVarint (field.value);
+
+        case fixed64:
+            if (end - pos < 8)
+                return false;
+
+            std::memcpy (&field.value, pos, 8);
+            pos += 8;
+            return true;
+
+        case fixed32:
+            if (end - pos < 4)
+                return false;
+
+            field.value = 0;
+            std::memcpy (&field.value, pos, 4);
+            pos += 4;
+            return true;
+
+        case lengthDelimited:
+        {
+            uint64_t length;
+
+            if (! readVarint (length) || length > (uint64_t) (end - pos))
+                return false;
+
+            field.payload = { pos, pos + length };
+            pos += length;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+} // namespace neural
@@ -0,0 +1,555 @@
+/*
+  ==============================================================================
+
+    OrtSessionCache.h
+
+    One Ort::Env for the whole process, and the sessions created in it,
+    shared by every plugin instance that opens the same model with the same
+    options. Sixty instances of a processor then hold one copy of the
+    optimised graph and its weights, and the instances after the first skip
+    graph optimisation entirely. Each instance keeps its own states, buffers
+    and IoBindings and calls Session::Run on the shared session, which ONNX
+    Runtime allows from several threads at once.
+
+    Sessions are keyed by the model's path, a hash of its contents and the
+    session settings. The cache only holds weak references, so a session
+    goes away with the last instance using it, and a model that changed on
+    disk gets a session of its own. Where X.ort sits next to X.onnx
+    (Tools/convert_models_to_ort.py), the session is created from the
+    pre-optimised .ort file; a reduced onnxruntime build
+    (Tools/build_minimal_onnxruntime.sh) can only read those.
+
+    For a .onnx file, the first session on a machine also saves the graph
+    ONNX Runtime optimised to a per-user cache (getGraphCacheDirectory),
+    under a name made of the model's hash, the ONNX Runtime version, the CPU
+    and the settings. Sessions in later processes load that graph with
+    optimisation turned off. NEURAL_ORT_GRAPH_CACHE=0 turns this off.
+
+    Sessions also share one CPU allocator, registered on the Env the first
+    time a session asks for it (session.use_env_allocators), instead of each
+    growing an arena of its own to its peak and keeping it. That allocator
+    is RealtimeOrtAllocator, which serves Run() from the calling processor's
+    preallocated RealtimeArena and everything else from the heap.
+    getSharedArenaUsage() reads the arenas' own counters, so it works with
+    every ONNX Runtime version; ONNX Runtime's arena statistics need 1.23.
+
+    Optionally (OrtThreadSettings), the Env owns global intra- and inter-op
+    thread pools and the sessions are created without pools of their own,
+    so the number of inference threads stays fixed however many instances
+    are open, and the threads can be pinned to cores the host does not use
+    for audio.
+
+    The sessions can also hand the nodes it supports to the XNNPACK
+    execution provider (NEURAL_ORT_XNNPACK=1, or useXnnpack in the session
+    settings); with an ONNX Runtime built without it they stay on the
+    default CPU provider. Tools/benchmark_providers.py compares the two.
+
+    Every session registers the neural::SelectiveScan operator
+    (SelectiveScanOp.h), so models whose scans Tools/fuse_selective_scan.py
+    fused load like any other.
+
+    Only include this when building with ONNX Runtime.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <onnxruntime_cxx_api.h>
+#include "CpuDispatch.h"
+#include "RealtimeAllocator.h"
+#include "SelectiveScanOp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+// Figures for the shared allocator, from RealtimeArena::getTotals(). The
+// arenas rewind after every Run(), so nothing is in use between blocks.
+struct OrtArenaUsage
+{
+    bool registered = false;
+    int numSessions = 0;                        // live sessions of the cache that use it
+    int64_t bytesReserved = 0;                  // all RealtimeArenas together
+    int64_t peakBytesInUse = 0;                 // the largest one arena's high-water mark
+    uint64_t numAllocations = 0;                // served by the arenas
+    uint64_t heapFallbacks = 0;                 // Run() allocations that missed their arena, pool threads' included
+    uint64_t poolThreadAllocations = 0;         // of those, from threads outside any arena's scope
+
+    std::string toString() const
+    {
+        if (! registered)
+            return "not registered";
+
+        return std::to_string (numSessions) + " sessions, reserved " + std::to_string (bytesReserved)
+             + " B, peak " + std::to_string (peakBytesInUse) + " B, " + std::to_string (numAllocations)
+             + " allocations, " + std::to_string (heapFallbacks) + " heap fallbacks ("
+             + std::to_string (poolThreadAllocations) + " from pool threads)";
+    }
+};
+
+//==============================================================================
+// Global thread pools on the Env. Off by default: every session then runs on
+// the thread that calls Run() (intraOpNumThreads of the session settings is 1).
+struct OrtThreadSettings
+{
+    bool useGlobalPools = false;
+    int intraOpNumThreads = 1;                  // the calling thread included
+    int interOpNumThreads = 1;
+
+    // ONNX Runtime's format: one ';'-separated entry per pool thread
+    // (intraOpNumThreads - 1 of them, the caller is not pinned), each a
+    // ','-separated list or a range of 1-based logical processors, e.g. "3;4" or "3-4;5-6"
+    std::string intraOpAffinity;
+
+    bool allowSpinning = false;                 // spinning workers take cores from the host
+
+    // NEURAL_ORT_THREADS=n turns the global pools on with n intra-op threads;
+    // NEURAL_ORT_AFFINITY pins them
+    static OrtThreadSettings fromEnvironment()
+    {
+        OrtThreadSettings settings;
+
+        if (const char* threads = std::getenv ("NEURAL_ORT_THREADS"))
+        {
+            settings.useGlobalPools = true;
+            settings.intraOpNumThreads = std::max (1, std::atoi (threads));
+        }
+
+        if (const char* affinity = std::getenv ("NEURAL_ORT_AFFINITY"))
+            settings.intraOpAffinity = affinity;
+
+        return settings;
+    }
+};
+
+//==============================================================================
+// NEURAL_ORT_XNNPACK=1 when the plugin loads
+inline bool isXnnpackRequested()
+{
+    const char* requested = std::getenv ("NEURAL_ORT_XNNPACK");
+    return requested != nullptr && std::string (requested) == "1";
+}
+
+// NEURAL_ORT_GRAPH_CACHE=0 when the plugin loads turns the optimised graph cache off
+inline bool isGraphCacheRequested()
+{
+    const char* requested = std::getenv ("NEURAL_ORT_GRAPH_CACHE");
+    return requested == nullptr || std::string (requested) != "0";
+}
+
+// Whether the ONNX Runtime the plugin runs against was built with XNNPACK
+inline bool isXnnpackAvailable()
+{
+    static const bool available = []
+    {
+        const auto providers = Ort::GetAvailableProviders();
+        return std::find (providers.begin(), providers.end(), "XnnpackExecutionProvider") != providers.end();
+    }();
+
+    return available;
+}
+
+//==============================================================================
+// How a session is built. Instances asking for different settings get
+// different sessions.
+struct OrtSessionSettings
+{
+    int intraOpNumThreads = 1;                  // the calling (audio) thread only
+    GraphOptimizationLevel optimizationLevel = GraphOptimizationLevel::ORT_ENABLE_ALL;
+    bool enableMemPattern = true;
+    bool enableCpuMemArena = true;
+    bool useSharedArena = true;                 // the Env's allocator rather than an arena per session
+    bool useXnnpack = isXnnpackRequested();     // ignored where the runtime lacks it
+    bool useGraphCache = isGraphCacheRequested();   // does not change the session, so not in the key
+
+    // XNNPACK is asked for and the runtime has it
+    bool usesXnnpack() const                    { return useXnnpack && isXnnpackAvailable(); }
+
+    Ort::SessionOptions createOptions() const
+    {
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads (intraOpNumThreads);
+        options.SetGraphOptimizationLevel (optimizationLevel);
+        options.SetExecutionMode (ORT_SEQUENTIAL);  // sequential execution across nodes
+
+        if (enableMemPattern)
+            options.EnableMemPattern();
+        else
+            options.DisableMemPattern();
+
+        if (enableCpuMemArena)
+            options.EnableCpuMemArena();
+        else
+            options.DisableCpuMemArena();
+
+        if (useSharedArena)
+            options.AddConfigEntry ("session.use_env_allocators", "1");
+
+        // For models whose scans Tools/fuse_selective_scan.py fused; an
+        // onnxruntime built without custom operators refuses the domain
+        try
+        {
+            options.Add (getSelectiveScanDomain());
+        }
+        catch (const Ort::Exception&) {}
+
+        // Appended before the CPU provider ONNX Runtime always adds, so
+        // XNNPACK takes the nodes it supports and MLAS keeps the rest. It runs
+        // them on as many threads as the session, so on the calling thread only.
+        if (usesXnnpack())
+        {
+            try
+            {
+                options.AppendExecutionProvider ("XNNPACK", { { "intra_op_num_threads", std::to_string (intraOpNumThreads) } });
+            }
+            catch (const Ort::Exception&) {}
+        }
+
+        return options;
+    }
+
+    std::string getKey() const
+    {
+        return std::to_string (intraOpNumThreads) + "/" + std::to_string ((int) optimizationLevel)
+             + (enableMemPattern ? "/pattern" : "") + (enableCpuMemArena ? "/arena" : "")
+             + (useSharedArena ? "/shared" : "") + (usesXnnpack() ? "/xnnpack" : "");
+    }
+};
+
+//==============================================================================
+class OrtSessionCache
+{
+public:
+    static OrtSessionCache& getInstance()
+    {
+        static OrtSessionCache cache;
+        return cache;
+    }
+
+    // Creates the Env on first use, with the thread settings in force then
+    Ort::Env& getEnv()
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        return createEnvIfNeeded();
+    }
+
+    // Takes effect if the Env does not exist yet; returns whether it did
+    bool setThreadSettings (const OrtThreadSettings& newSettings)
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+
+        if (env != nullptr)
+            return false;
+
+        threadSettings = newSettings;
+        return true;
+    }
+
+    OrtThreadSettings getThreadSettings()
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        return threadSettings;
+    }
+
+    // The file a session for modelPath is created from: X.ort when it exists
+    // beside X.onnx, modelPath otherwise
+    static std::string getSessionModelPath (const std::string& modelPath)
+    {
+        const auto extension = modelPath.rfind (".onnx");
+
+        if (extension == std::string::npos || extension + 5 != modelPath.size())
+            return modelPath;
+
+        const auto ortPath = modelPath.substr (0, extension) + ".ort";
+        return std::ifstream (ortPath).good() ? ortPath : modelPath;
+    }
+
+    // The session for a model file (or its .ort form, see
+    // getSessionModelPath): created on the first request for it, shared
+    // after that. Reads and hashes the file on every call, and may create a
+    // session, so call it from a loader thread. Throws std::runtime_error
+    // when the file cannot be read and Ort::Exception when ONNX Runtime
+    // rejects it.
+    std::shared_ptr<Ort::Session> acquire (const std::string& modelPath, const OrtSessionSettings& settings = {})
+    {
+        const auto sessionPath = getSessionModelPath (modelPath);
+        const auto model = readFile (sessionPath);
+        const auto key = sessionPath + "|" + std::to_string (hash (model.data(), model.size())) + "|" + settings.getKey();
+
+        // Held while creating, so concurrent instances of one model wait for
+        // the first one's session instead of each building their own
+        const std::lock_guard<std::mutex> guard (lock);
+
+        for (auto entry = sessions.begin(); entry != sessions.end();)
+            entry = entry->second.session.expired() ? sessions.erase (entry) : std::next (entry);
+
+        if (auto session = sessions[key].session.lock())
+            return session;
+
+        createEnvIfNeeded();
+
+        if (settings.useSharedArena && ! sharedArenaRegistered)
+            registerSharedArena();
+
+        const auto createOptions = [&]
+        {
+            auto options = settings.createOptions();
+
+            if (threadSettings.useGlobalPools)
+            {
+                options.DisablePerSessionThreads();
+                options.AddConfigEntry ("session.set_denormal_as_zero", "1");   // must match the global pools
+            }
+
+            return options;
+        };
+
+        std::unique_ptr<Ort::Session> created;
+
+        if (sessionPath != modelPath)
+        {
+            // Already optimised when it was converted; ONNX Runtime only loads it
+            auto options = createOptions();
+            options.AddConfigEntry ("session.load_model_format", "ORT");
+            created = std::make_unique<Ort::Session> (*env, model.data(), model.size(), options);
+        }
+        else
+        {
+            created = createThroughGraphCache (model, settings, createOptions);
+        }
+
+        // The deleter keeps the Env alive for as long as any of its sessions
+        std::shared_ptr<Ort::Session> session (created.release(), [envInUse = env] (Ort::Session* s) { delete s; });
+        sessions[key] = { session, settings.useSharedArena };
+        return session;
+    }
+
+    OrtArenaUsage getSharedArenaUsage()
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        OrtArenaUsage usage;
+        usage.registered = sharedArenaRegistered;
+
+        for (const auto& entry : sessions)
+            usage.numSessions += entry.second.usesSharedArena && ! entry.second.session.expired() ? 1 : 0;
+
+        const auto& totals = RealtimeArena::getTotals();
+        usage.bytesReserved = totals.capacity.load (std::memory_order_relaxed);
+        usage.peakBytesInUse = totals.largestHighWaterMark.load (std::memory_order_relaxed);
+        usage.numAllocations = totals.allocations.load (std::memory_order_relaxed);
+        usage.heapFallbacks = RealtimeOrtAllocator::getInstance().getHeapFallbacks();
+        usage.poolThreadAllocations = totals.poolThreadAllocations.load (std::memory_order_relaxed);
+        return usage;
+    }
+
+    // Where optimised graphs are kept: NEURAL_ORT_GRAPH_CACHE_DIR if set,
+    // otherwise the user's cache folder (~/Library/Caches on macOS,
+    // %LOCALAPPDATA% on Windows, $XDG_CACHE_HOME or ~/.cache elsewhere).
+    // Empty when there is none. Any of its files can be deleted at any time.
+    static std::filesystem::path getGraphCacheDirectory()
+    {
+        if (const char* directory = std::getenv ("NEURAL_ORT_GRAPH_CACHE_DIR"))
+            return directory;
+
+       #if defined (_WIN32)
+        const char* base = std::getenv ("LOCALAPPDATA");
+        return base != nullptr ? std::filesystem::path (base) / "NeuralModels" / "GraphCache" : std::filesystem::path();
+       #else
+        const char* home = std::getenv ("HOME");
+        #if defined (__APPLE__)
+         return home != nullptr ? std::filesystem::path (home) / "Library" / "Caches" / "NeuralModels" : std::filesystem::path();
+        #else
+         if (const char* xdg = std::getenv ("XDG_CACHE_HOME"))
+             return std::filesystem::path (xdg) / "NeuralModels";
+
+         return home != nullptr ? std::filesystem::path (home) / ".cache" / "NeuralModels" : std::filesystem::path();
+        #endif
+       #endif
+    }
+
+    // Sessions currently held by at least one instance
+    size_t getNumSessions()
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        size_t numLive = 0;
+
+        for (const auto& entry : sessions)
+            numLive += entry.second.session.expired() ? 0 : 1;
+
+        return numLive;
+    }
+
+private:
+    OrtSessionCache()
+        : threadSettings (OrtThreadSettings::fromEnvironment())
+    {
+    }
+
+    Ort::Env& createEnvIfNeeded()
+    {
+        if (env != nullptr)
+            return *env;
+
+        if (! threadSettings.useGlobalPools)
+        {
+            env = std::make_shared<Ort::Env> (ORT_LOGGING_LEVEL_WARNING, "NeuralModels");
+            return *env;
+        }
+
+        // Pool threads flush denormals like the audio thread does
+        Ort::ThreadingOptions threading;
+        threading.SetGlobalIntraOpNumThreads (threadSettings.intraOpNumThreads);
+        threading.SetGlobalInterOpNumThreads (threadSettings.interOpNumThreads);
+        threading.SetGlobalSpinControl (threadSettings.allowSpinning ? 1 : 0);
+        threading.SetGlobalDenormalAsZero();
+
+        if (! threadSettings.intraOpAffinity.empty())
+            Ort::ThrowOnError (Ort::GetApi().SetGlobalIntraOpThreadAffinity (threading, threadSettings.intraOpAffinity.c_str()));
+
+        env = std::make_shared<Ort::Env> (threading, ORT_LOGGING_LEVEL_WARNING, "NeuralModels");
+        return *env;
+    }
+
+    // Loads the optimised graph a previous session saved for this model,
+    // runtime, CPU and settings, or creates the session from the model and
+    // saves its graph. A graph that fails to load is deleted and saved again;
+    // when saving fails, the session is created as if there were no cache.
+    template <typename CreateOptions>
+    std::unique_ptr<Ort::Session> createThroughGraphCache (const std::vector<char>& model, const OrtSessionSettings& settings,
+                                                           const CreateOptions& createOptions)
+    {
+        namespace fs = std::filesystem;
+        const auto directory = settings.useGraphCache ? getGraphCacheDirectory() : fs::path();
+
+        if (directory.empty())
+            return std::make_unique<Ort::Session> (*env, model.data(), model.size(), createOptions());
+
+        const auto cached = directory / getGraphCacheName (model, settings);
+        std::error_code error;
+
+        if (fs::exists (cached, error))
+        {
+            try
+            {
+                const auto graph = readFile (cached.string());
+                auto options = createOptions();
+                options.SetGraphOptimizationLevel (GraphOptimizationLevel::ORT_DISABLE_ALL);
+                options.AddConfigEntry ("session.load_model_format", "ORT");
+                return std::make_unique<Ort::Session> (*env, graph.data(), graph.size(), options);
+            }
+            catch (const std::exception&)
+            {
+                fs::remove (cached, error);
+            }
+        }
+
+        // Saved under a name of its own, then renamed, so a process loading
+        // the graph never sees half of it, and of two writing it, one wins
+        auto partial = cached;
+        partial += "." + std::to_string (std::chrono::steady_clock::now().time_since_epoch().count()) + ".partial";
+
+        try
+        {
+            fs::create_directories (directory, error);
+
+            auto options = createOptions();
+            options.AddConfigEntry ("session.save_model_format", "ORT");
+            options.SetOptimizedModelFilePath (partial.c_str());
+
+            auto session = std::make_unique<Ort::Session> (*env, model.data(), model.size(), options);
+            fs::rename (partial, cached, error);
+            fs::remove (partial, error);
+            return session;
+        }
+        catch (const Ort::Exception&)
+        {
+            fs::remove (partial, error);
+            return std::make_unique<Ort::Session> (*env, model.data(), model.size(), createOptions());
+        }
+    }
+
+    // <model hash>-ort<version>-<CPU>-<settings hash>.ort. ONNX Runtime's
+    // optimised graph depends on the vector unit (the NCHWc layout does).
+    static std::string getGraphCacheName (const std::vector<char>& model, const OrtSessionSettings& settings)
+    {
+        const char* cpuNames[] = { "scalar", "sse2", "avx2", "avx512", "neon" };
+        const auto key = settings.getKey();
+
+        return toHex (hash (model.data(), model.size())) + "-ort" + Ort::GetVersionString() + "-"
+             + cpuNames[(int) detail::detectSimdLevel()] + "-" + toHex (hash (key.data(), key.size())).substr (0, 8) + ".ort";
+    }
+
+    static std::string toHex (uint64_t value)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string text (16, '0');
+
+        for (int i = 15; i >= 0; --i, value >>= 4)
+            text[(size_t) i] = digits[value & 15];
+
+        return text;
+    }
+
+    void registerSharedArena()
+    {
+        env->RegisterAllocator (&RealtimeOrtAllocator::getInstance());
+        sharedArenaRegistered = true;
+    }
+
+    static std::vector<char> readFile (const std::string& path)
+    {
+        std::ifstream file (path, std::ios::binary | std::ios::ate);
+
+        if (! file)
+            throw std::runtime_error ("cannot open " + path);
+
+        std::vector<char> bytes ((size_t) file.tellg());
+        file.seekg (0);
+
+        if (! file.read (bytes.data(), (std::streamsize) bytes.size()))
+            throw std::runtime_error ("cannot read " + path);
+
+        return bytes;
+    }
+
+    // 64-bit FNV-1a
+    static uint64_t hash (const char* bytes, size_t size)
+    {
+        uint64_t h = 14695981039346656037ull;
+
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ (uint8_t) bytes[i]) * 1099511628211ull;
+
+        return h;
+    }
+
+    struct Entry
+    {
+        std::weak_ptr<Ort::Session> session;
+        bool usesSharedArena = false;
+    };
+
+    std::shared_ptr<Ort::Env> env;                  // created by the first session
+    OrtThreadSettings threadSettings;
+    std::mutex lock;
+    std::map<std::string, Entry> sessions;
+
+    bool sharedArenaRegistered = false;
+};
+
+} // namespace neural
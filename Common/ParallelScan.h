@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    ParallelScan.h
+
+    Offline rendering of long blocks on every core. Once their inputs are
+    known, the selective-scan layers' running sums (see SelectiveScanBlock)
+    add up segment by segment, so a long sequence can be cut into segments
+    that are scanned at the same time:
+
+        1. every segment but the last is scanned from zero sums, for the sum
+           of its decays (SelectiveScanBlock::propagate), and the true S at
+           the start of each segment is chained through those, one segment
+           at a time (a few vector operations each),
+        2. the same again from those starts, for the guarded sums: the
+           export's 1e-12 guard makes each input's share depend on S itself,
+           so this pass has to wait for the first,
+        3. every segment is run again from its true start, producing output.
+
+    That is three times the arithmetic of the sequential path, spread over
+    all threads. The output matches it to float rounding: only the segment
+    starts differ, by the rounding of the chaining.
+
+    The models' renderParallel() functions are called from inside a
+    CpuDispatch entry and run their per-segment work through
+    parallelFor<Ops>, which keeps it in an entry of the same instruction set.
+    Worker threads are started on the first parallel call, never from a
+    real-time one, and flush denormals like the audio thread does. The
+    processors all render with TaskPool::getShared(), so instances bouncing
+    at the same time take turns on one set of threads instead of each
+    starting one per core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CpuDispatch.h"
+
+namespace neural
+{
+
+//==============================================================================
+/** A fixed set of worker threads that run the tasks of one call at a time;
+    calls from several threads wait their turn.
+*/
+class TaskPool
+{
+public:
+    // 0 uses one thread per hardware thread, the calling one included
+    explicit TaskPool (int numThreadsToUse = 0)
+        : numThreads (numThreadsToUse > 0 ? numThreadsToUse
+                                          : (int) std::max (1u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    // The process-wide pool, created on first use and shared by every holder;
+    // it goes away, joining its threads, with the last one
+    static std::shared_ptr<TaskPool> getShared()
+    {
+        static std::mutex sharedLock;
+        static std::weak_ptr<TaskPool> shared;
+
+        const std::lock_guard<std::mutex> guard (sharedLock);
+        auto pool = shared.lock();
+
+        if (pool == nullptr)
+        {
+            pool = std::make_shared<TaskPool>();
+            shared = pool;
+        }
+
+        return pool;
+    }
+
+    ~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard (lock);
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    int getNumThreads() const                   { return numThreads; }
+
+    // Calls task (0) .. task (numTasks - 1) across the workers and the calling
+    // thread, and returns once all of them are done
+    void run (int numTasks, const std::function<void (int)>& task)
+    {
+        if (numThreads <= 1 || numTasks <= 1)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                task (i);
+
+            return;
+        }
+
+        const std::lock_guard<std::mutex> turn (callLock);
+        startWorkers();
+
+        {
+            std::lock_guard<std::mutex> guard (lock);
+            job = &task;
+            jobSize = numTasks;
+            remaining = numTasks;
+            nextTask.store (0);
+            ++generation;
+        }
+
+        wake.notify_all();
+        work (task, numTasks);
+
+        std::unique_lock<std::mutex> guard (lock);
+        finished.wait (guard, [this] { return remaining == 0 && busyWorkers == 0; });
+        job = nullptr;
+    }
+
+private:
+    const int numThreads;
+    std::vector<std::thread> workers;
+
+    std::mutex callLock;                        // held for a whole run()
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    const std::function<void (int)>* job = nullptr;
+    int jobSize = 0, remaining = 0, busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+    std::atomic<int> nextTask { 0 };
+
+    void startWorkers()
+    {
+        if (! workers.empty())
+            return;
+
+        for (int i = 1; i < numThreads; ++i)
+            workers.emplace_back ([this] { workerLoop(); });
+    }
+
+    void work (const std::function<void (int)>& task, int numTasks)
+    {
+        for (int i = nextTask.fetch_add (1); i < numTasks; i = nextTask.fetch_add (1))
+        {
+            task (i);
+
+            std::lock_guard<std::mutex> guard (lock);
+
+            if (--remaining == 0)
+                finished.notify_all();
+        }
+    }
+
+    void workerLoop()
+    {
+        flushDenormals();
+
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> guard (lock);
+
+        for (;;)
+        {
+            wake.wait (guard, [&] { return stopping || (generation != seen && job != nullptr); });
+
+            if (stopping)
+                return;
+
+            seen = generation;
+            auto* task = job;
+            const auto numTasks = jobSize;
+            ++busyWorkers;
+
+            guard.unlock();
+            work (*task, numTasks);
+            guard.lock();
+
+            if (--busyWorkers == 0 && remaining == 0)
+                finished.notify_all();
+        }
+    }
+
+    static void flushDenormals()
+    {
+       #if NEURAL_FASTMATH_X86
+        _mm_setcsr (_mm_getcsr() | 0x8040);     // FTZ and DAZ
+       #elif NEURAL_FASTMATH_AARCH64 && (defined (__GNUC__) || defined (__clang__))
+        uint64_t fpcr;
+        __asm__ volatile ("mrs %0, fpcr" : "=r" (fpcr));
+        __asm__ volatile ("msr fpcr, %0" : : "r" (fpcr | (1ull << 24)));
+       #endif
+    }
+};
+
+//==============================================================================
+namespace detail
+{
+    struct InvokeKernel
+    {
+        template <typename Ops, typename Fn>
+        static void run (const Fn* fn, int index)   { (*fn) (index); }
+    };
+}
+
+// TaskPool::run for a task that uses Ops: each call goes through the
+// CpuDispatch entry for Ops, so the task inlines into code of that target
+template <typename Ops, typename Fn>
+void parallelFor (TaskPool& pool, int numTasks, const Fn& task)
+{
+    auto* entry = SimdDispatch<detail::InvokeKernel>::template entryFor<Ops, const Fn*, int>();
+    pool.run (numTasks, [&] (int index) { entry (&task, index); });
+}
+
+//==============================================================================
+/** How a block is cut for the pool: about two segments per thread, none
+    shorter than minLength samples.
+*/
+struct ScanSegments
+{
+    static constexpr int minLength = 2048;
+
+    ScanSegments (int numSamplesToSplit, const TaskPool& pool)
+        : numSamples (numSamplesToSplit),
+          numSegments (std::max (1, std::min (2 * pool.getNumThreads(), numSamplesToSplit / minLength)))
+    {
+    }
+
+    // Whether splitting a block this long across the pool is worth it
+    static bool worthSplitting (int numSamples, const TaskPool& pool)
+    {
+        return pool.getNumThreads() > 1 && numSamples >= 2 * minLength;
+    }
+
+    int begin (int segment) const               { return (int) ((int64_t) numSamples * segment / numSegments); }
+    int end (int segment) const                 { return begin (segment + 1); }
+    int length (int segment) const              { return end (segment) - begin (segment); }
+
+    const int numSamples, numSegments;
+};
+
+//==============================================================================
+// Steps 1 and 2 for one scan block over input rows x ([numSamples][ModelSize]):
+// fills starts with the state each segment begins with, the first being initial
+template <typename Ops, typename Block>
+void findSegmentStarts (TaskPool& pool, const Block& block, const float* x, const ScanSegments& segments,
+                        const typename Block::State& initial, std::vector<typename Block::State>& starts)
+{
+    using State = typename Block::State;
+    constexpr int stateSize = Block::scanStateSize;
+    constexpr int rowSize = Block::modelSize;
+
+    const auto numSegments = segments.numSegments;
+
+    std::vector<State> locals ((size_t) numSegments);
+
+    starts.resize ((size_t) numSegments);
+    starts[0] = initial;
+
+    // Runs every segment but the last from its start as it stands, with the
+    // sum being found zeroed; a segment after the first is mid-call
+    auto propagateSegments = [&] (auto zeroSum)
+    {
+        parallelFor<Ops> (pool, numSegments - 1, [&] (int s)
+        {
+            auto& local = locals[(size_t) s];
+            local = starts[(size_t) s];
+            zeroSum (local);
+
+            if (s > 0)
+                local.callStarted = true;
+
+            block.template propagate<Ops> (x + segments.begin (s) * rowSize, segments.length (s), local);
+        });
+    };
+
+    for (int s = 1; s < numSegments; ++s)
+    {
+        starts[(size_t) s] = initial;
+        block.seedConvHistory (x + segments.begin (s) * rowSize, starts[(size_t) s]);
+    }
+
+    propagateSegments ([] (State& local) { std::fill (&local.logDecay[0][0], &local.logDecay[0][0] + stateSize, 0.0f); });
+
+    for (int s = 1; s < numSegments; ++s)
+        Block::chainLogDecay (starts[(size_t) s - 1], locals[(size_t) s - 1], starts[(size_t) s]);
+
+    propagateSegments ([] (State& local) { std::fill (&local.guardedSum[0][0], &local.guardedSum[0][0] + stateSize, 0.0f); });
+
+    for (int s = 1; s < numSegments; ++s)
+        Block::chainGuardedSum (starts[(size_t) s - 1], locals[(size_t) s - 1], starts[(size_t) s]);
+}
+
+} // namespace neural
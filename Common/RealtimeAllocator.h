@@ -0,0 +1,352 @@
+/*
+  ==============================================================================
+
+    RealtimeAllocator.h
+
+    Keeps ONNX Runtime's allocations inside Run() off the system heap. The
+    OrtAllocator registered on the Env (see OrtSessionCache.h) serves a
+    thread from the RealtimeArena it has entered with RealtimeArena::Scope:
+    a region each processor reserves up front and bumps through, with no
+    locks. Free() only counts, atomically, so it may come from any thread.
+    The first allocation after nothing in the region is live, which is the
+    case by the time Run() returns, rewinds it, so every block starts from
+    an empty arena. Only the thread in the scope allocates from a region.
+
+    Outside a scope (creating sessions, reading initializers) the allocator
+    uses the heap. So does an allocation inside a scope that does not fit;
+    those are counted, and the required size is remembered for the next
+    reserve(). This relies on ONNX Runtime freeing everything a Run()
+    allocates before it returns: what lives longer (initializers, prepacked
+    weights) is allocated when the session is created.
+
+    ONNX Runtime's intra-op pool threads (OrtThreadSettings, or sessions
+    with more than one intra-op thread) are in no scope, so what they
+    allocate for a Run() comes from the heap. An arena cannot tell them
+    apart, so they are counted process-wide: every allocation outside a
+    scope while a scope is open counts in Totals::poolThreadAllocations and
+    as a heap fallback in the totals and RealtimeOrtAllocator. That may
+    include another thread creating a session at the same time, so it errs
+    high. With the default single intra-op thread it stays at zero.
+
+    The arena is sized by measuring: between beginMeasuring() and reserve()
+    every allocation comes from the heap while the arena works out how far
+    it would have bumped. The processors run each bound block length once
+    that way on their loader thread, the first time the model sees a block
+    size, and cache the result with it. That also lets ONNX Runtime plan its
+    memory pattern for each shape before the audio thread sees it.
+
+    Each arena counts its capacity, the most of it one Run() used and the
+    allocations it served or sent to the heap, and RealtimeArena::getTotals()
+    sums them over the process. Unlike ONNX Runtime's arena statistics
+    (1.23 and later), they work with any runtime version.
+
+    Only include this when building with ONNX Runtime.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+class RealtimeArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    // Makes the arena the one the calling thread's allocations come from,
+    // until the scope ends
+    class Scope
+    {
+    public:
+        explicit Scope (RealtimeArena& arena)
+            : previous (current()), counted (! arena.isMeasuring())
+        {
+            current() = &arena;
+
+            if (counted)
+                getTotals().openScopes.fetch_add (1, std::memory_order_relaxed);
+        }
+
+        ~Scope()
+        {
+            if (counted)
+                getTotals().openScopes.fetch_sub (1, std::memory_order_relaxed);
+
+            current() = previous;
+        }
+
+    private:
+        RealtimeArena* previous;
+        bool counted;           // measuring scopes use the heap anyway
+
+        Scope (const Scope&) = delete;
+        Scope& operator= (const Scope&) = delete;
+    };
+
+    static RealtimeArena*& current()
+    {
+        static thread_local RealtimeArena* arena = nullptr;
+        return arena;
+    }
+
+    // Every arena in the process together; readable from any thread
+    struct Totals
+    {
+        std::atomic<int64_t> numArenas { 0 };
+        std::atomic<int64_t> capacity { 0 };
+        std::atomic<int64_t> largestHighWaterMark { 0 };     // of any one arena
+        std::atomic<uint64_t> allocations { 0 };
+        std::atomic<uint64_t> heapFallbacks { 0 };          // pool-thread allocations included
+        std::atomic<uint64_t> poolThreadAllocations { 0 };  // outside any scope while one was open
+        std::atomic<int64_t> openScopes { 0 };
+    };
+
+    static Totals& getTotals()
+    {
+        static Totals totals;
+        return totals;
+    }
+
+    RealtimeArena()                             { getTotals().numArenas.fetch_add (1, std::memory_order_relaxed); }
+
+    ~RealtimeArena()
+    {
+        setCapacity (0);
+        getTotals().numArenas.fetch_sub (1, std::memory_order_relaxed);
+    }
+
+    // Drops the region; allocations go to the heap, uncounted, while the
+    // arena records the size it needs
+    void beginMeasuring()
+    {
+        storage = {};
+        base = nullptr;
+        setCapacity (0);
+        offset = 0;
+        requiredBytes = 0;
+        measuring = true;
+    }
+
+    // Allocates; call it from prepareToPlay or the loader thread
+    void reserve (size_t bytes)
+    {
+        storage.assign (bytes + alignment, 0);
+
+        const auto misalignment = reinterpret_cast<std::uintptr_t> (storage.data()) % alignment;
+        base = storage.data() + (misalignment == 0 ? 0 : alignment - misalignment);
+        setCapacity (bytes);
+        offset = 0;
+        numLive.store (0, std::memory_order_relaxed);
+        highWaterMark.store (0, std::memory_order_relaxed);
+        measuring = false;
+    }
+
+    // What measuring found, plus a quarter for shapes it did not see
+    void reserveMeasured()                      { reserve (requiredBytes + requiredBytes / 4); }
+
+    // Bytes the largest Run() so far needed, measured or missed
+    size_t getRequiredBytes() const             { return requiredBytes; }
+
+    // The counters below can be read from any thread
+    size_t getCapacity() const                  { return capacity.load (std::memory_order_relaxed); }
+
+    // The most of the region one Run() has used since reserve()
+    size_t getHighWaterMark() const             { return highWaterMark.load (std::memory_order_relaxed); }
+
+    // Allocations the region served
+    uint64_t getNumAllocations() const          { return numAllocations.load (std::memory_order_relaxed); }
+
+    // Allocations inside a scope that went to the heap because the region was
+    // full. Pool threads' allocations are only in the totals (see above).
+    uint64_t getHeapFallbacks() const           { return heapFallbacks.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Called by RealtimeOrtAllocator on the thread in the scope; size includes
+    // the allocator's header. Returns nullptr when the heap has to serve it.
+    void* allocate (size_t size)
+    {
+        // Every block is free again, whichever thread freed it
+        if (numLive.load (std::memory_order_acquire) == 0)
+            offset = 0;
+
+        const auto end = offset + roundUp (size);
+        requiredBytes = std::max (requiredBytes, end);
+
+        if (measuring)
+        {
+            offset = end;
+            numLive.fetch_add (1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (end > capacity.load (std::memory_order_relaxed))
+        {
+            heapFallbacks.fetch_add (1, std::memory_order_relaxed);
+            getTotals().heapFallbacks.fetch_add (1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto* block = base + offset;
+        offset = end;
+        numLive.fetch_add (1, std::memory_order_relaxed);
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+        getTotals().allocations.fetch_add (1, std::memory_order_relaxed);
+
+        if (end > highWaterMark.load (std::memory_order_relaxed))
+            raiseHighWaterMark (end);
+
+        return block;
+    }
+
+    // A block allocate() handed out (or, when measuring, counted) is free
+    // again; any thread may call it. The next allocate() rewinds.
+    void release()                              { numLive.fetch_sub (1, std::memory_order_release); }
+
+    bool isMeasuring() const                    { return measuring; }
+
+private:
+    static size_t roundUp (size_t size)         { return (size + alignment - 1) / alignment * alignment; }
+
+    void setCapacity (size_t bytes)
+    {
+        const auto previous = capacity.exchange (bytes, std::memory_order_relaxed);
+        getTotals().capacity.fetch_add ((int64_t) bytes - (int64_t) previous, std::memory_order_relaxed);
+    }
+
+    // Only the thread in the scope writes the arena's mark; the total is shared
+    void raiseHighWaterMark (size_t bytes)
+    {
+        highWaterMark.store (bytes, std::memory_order_relaxed);
+
+        auto& largest = getTotals().largestHighWaterMark;
+        auto seen = largest.load (std::memory_order_relaxed);
+
+        while ((int64_t) bytes > seen && ! largest.compare_exchange_weak (seen, (int64_t) bytes, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::vector<unsigned char> storage;
+    unsigned char* base = nullptr;
+    size_t offset = 0, requiredBytes = 0;       // only the thread in the scope touches these
+    std::atomic<size_t> numLive { 0 };          // released from any thread
+    bool measuring = false;
+    std::atomic<size_t> capacity { 0 }, highWaterMark { 0 };
+    std::atomic<uint64_t> numAllocations { 0 }, heapFallbacks { 0 };
+
+    RealtimeArena (const RealtimeArena&) = delete;
+    RealtimeArena& operator= (const RealtimeArena&) = delete;
+};
+
+//==============================================================================
+// The allocator the sessions share through the Env. Trivially destructible,
+// so it can outlive everything at shutdown.
+class RealtimeOrtAllocator : public OrtAllocator
+{
+public:
+    static RealtimeOrtAllocator& getInstance()
+    {
+        static RealtimeOrtAllocator allocator;
+        return allocator;
+    }
+
+    // Heap allocations made inside a scope because its arena was full, across
+    // all arenas, and those pool threads made while a scope was open
+    uint64_t getHeapFallbacks() const           { return heapFallbacks.load (std::memory_order_relaxed); }
+
+private:
+    RealtimeOrtAllocator()
+        : OrtAllocator()
+    {
+        version = 18;       // up to Reserve
+        Alloc = [] (OrtAllocator* self, size_t size)           { return static_cast<RealtimeOrtAllocator*> (self)->allocate (size); };
+        Free = [] (OrtAllocator*, void* p)                      { deallocate (p); };
+        Info = [] (const OrtAllocator* self)                    { return static_cast<const OrtMemoryInfo*> (static_cast<const RealtimeOrtAllocator*> (self)->memoryInfo); };
+        Reserve = [] (OrtAllocator* self, size_t size)         { return static_cast<RealtimeOrtAllocator*> (self)->allocate (size); };
+
+        // Never released: ONNX Runtime may ask for it until the process ends
+        memoryInfo = Ort::MemoryInfo::CreateCpu (OrtDeviceAllocator, OrtMemTypeDefault).release();
+    }
+
+    // Every block starts with where it came from, one alignment unit before
+    // the pointer ONNX Runtime gets
+    struct Header
+    {
+        RealtimeArena* arena;
+        void* heapBlock;
+    };
+
+    static constexpr size_t headerSize = RealtimeArena::alignment;
+
+    void* allocate (size_t size)
+    {
+        auto* arena = RealtimeArena::current();
+        unsigned char* block = nullptr;
+
+        if (arena != nullptr)
+            block = static_cast<unsigned char*> (arena->allocate (headerSize + size));
+
+        if (block != nullptr)
+        {
+            new (block) Header { arena, nullptr };
+            return block + headerSize;
+        }
+
+        if (arena != nullptr && ! arena->isMeasuring())
+        {
+            heapFallbacks.fetch_add (1, std::memory_order_relaxed);
+        }
+        else if (arena == nullptr && RealtimeArena::getTotals().openScopes.load (std::memory_order_relaxed) > 0)
+        {
+            // Most likely a pool thread working for a Run() in a scope
+            auto& totals = RealtimeArena::getTotals();
+            totals.poolThreadAllocations.fetch_add (1, std::memory_order_relaxed);
+            totals.heapFallbacks.fetch_add (1, std::memory_order_relaxed);
+            heapFallbacks.fetch_add (1, std::memory_order_relaxed);
+        }
+
+        auto* heapBlock = static_cast<unsigned char*> (std::malloc (headerSize + size + RealtimeArena::alignment));
+
+        if (heapBlock == nullptr)
+            return nullptr;
+
+        const auto misalignment = reinterpret_cast<std::uintptr_t> (heapBlock) % RealtimeArena::alignment;
+        block = heapBlock + (misalignment == 0 ? 0 : RealtimeArena::alignment - misalignment);
+
+        // A measured allocation still has to be released from its arena
+        new (block) Header { arena != nullptr && arena->isMeasuring() ? arena : nullptr, heapBlock };
+        return block + headerSize;
+    }
+
+    static void deallocate (void* p)
+    {
+        if (p == nullptr)
+            return;
+
+        const auto* header = reinterpret_cast<const Header*> (static_cast<unsigned char*> (p) - headerSize);
+
+        if (header->arena != nullptr)
+            header->arena->release();
+
+        if (header->heapBlock != nullptr)
+            std::free (header->heapBlock);
+    }
+
+    OrtMemoryInfo* memoryInfo = nullptr;
+    std::atomic<uint64_t> heapFallbacks { 0 };
+};
+
+} // namespace neural
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    SelectiveScanOp.h
+
+    The selective scan of the exported Mamba/S6 layers as one ONNX Runtime
+    custom operator, neural::SelectiveScan. The export writes the scan in
+    parallel form: Softplus, the [T, D, N] products dt * A and dt * x * B, a
+    Pad / Slice / CumSum of the decays, Exp, a CumSum of the inputs divided
+    by the decays, the C readout and a Gather of the last state. ONNX
+    Runtime materialises every one of those [T, D, N] intermediates per
+    block. This kernel advances the same sums one time step after the other
+    instead, 1e-12 guard included, like the native SelectiveScanBlock (see
+    NeuralLayers.h), keeping only a few of them per state at a time:
+
+        dt   = softplus (delta[t, d])
+        S    = sum of dt * A[d, n] from the second step on
+        g    = g + dt * x[t, d] * B[t, n] / (exp (S) + 1e-12)
+        h    = exp (S) * g + exp (dt[0] * A[d, n] + S) * h0
+        y[t, d] = sum over n of h * C[t, n]
+
+    Inputs, per batch item:  delta [B, T, D] (before the softplus), A [D, N],
+    x [B, T, D], B [B, T, N], C [B, T, N], h [B, 1 or D, N]. Outputs:
+    y [B, T, D] and new_h [B, D, N], the state after the last step.
+
+    Tools/fuse_selective_scan.py puts it into a model. OrtSessionSettings
+    registers the operator on every session, and Tools/SelectiveScanOpLibrary.cpp
+    builds it as a library for the Python tools. The activations come from
+    FastMath.h, like the native path's.
+
+    Only include this when building with ONNX Runtime.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <onnxruntime_cxx_api.h>
+#include "FastMath.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+struct SelectiveScanKernel
+{
+    static constexpr int chunkSize = 64;     // states scanned together
+    static constexpr float guard = 1.0e-12f; // the export's epsilon
+
+    void Compute (OrtKernelContext* context)
+    {
+        Ort::KernelContext kernelContext (context);
+
+        const auto delta = kernelContext.GetInput (0);
+        const auto A = kernelContext.GetInput (1);
+        const auto x = kernelContext.GetInput (2);
+        const auto B = kernelContext.GetInput (3);
+        const auto C = kernelContext.GetInput (4);
+        const auto h = kernelContext.GetInput (5);
+
+        const auto deltaShape = delta.GetTensorTypeAndShapeInfo().GetShape();
+        const auto aShape = A.GetTensorTypeAndShapeInfo().GetShape();
+        const auto hShape = h.GetTensorTypeAndShapeInfo().GetShape();
+
+        if (deltaShape.size() != 3 || aShape.size() != 2 || hShape.size() != 3 || aShape[0] != deltaShape[2]
+             || (hShape[1] != 1 && hShape[1] != aShape[0]) || hShape[2] != aShape[1]
+             || (hShape[0] != 1 && hShape[0] != deltaShape[0]))
+            throw Ort::Exception ("SelectiveScan: inputs do not match", ORT_INVALID_ARGUMENT);
+
+        Shape shape;
+        shape.batch = deltaShape[0];
+        shape.length = deltaShape[1];
+        shape.inner = deltaShape[2];
+        shape.states = aShape[1];
+        shape.hBatch = hShape[0];
+        shape.hRows = hShape[1];
+
+        auto y = kernelContext.GetOutput (0, deltaShape);
+        auto newH = kernelContext.GetOutput (1, { shape.batch, shape.inner, shape.states });
+
+        scan (shape, delta.GetTensorData<float>(), A.GetTensorData<float>(), x.GetTensorData<float>(),
+              B.GetTensorData<float>(), C.GetTensorData<float>(), h.GetTensorData<float>(),
+              y.GetTensorMutableData<float>(), newH.GetTensorMutableData<float>());
+    }
+
+    struct Shape
+    {
+        int64_t batch, length, inner, states;
+        int64_t hBatch, hRows;                  // h may hold one row for every inner channel
+    };
+
+    // The scan itself, a chunk of one inner channel's states through the whole
+    // block at a time; runs the state in place in newH, so allocates nothing
+    static void scan (const Shape& s, const float* delta, const float* A, const float* x, const float* B,
+                      const float* C, const float* h, float* y, float* newH)
+    {
+        std::fill (y, y + s.batch * s.length * s.inner, 0.0f);
+
+        for (int64_t b = 0; b < s.batch; ++b)
+        {
+            float* state = newH + b * s.inner * s.states;
+            const float* starts = h + std::min (b, s.hBatch - 1) * s.hRows * s.states;
+
+            for (int64_t d = 0; d < s.inner; ++d)
+            {
+                const float* a = A + d * s.states;
+                float* hd = state + d * s.states;
+
+                std::copy (starts + (s.hRows == 1 ? 0 : d) * s.states, starts + (s.hRows == 1 ? 1 : d + 1) * s.states, hd);
+
+                for (int64_t n0 = 0; n0 < s.states; n0 += chunkSize)
+                {
+                    const auto count = (int) std::min<int64_t> (chunkSize, s.states - n0);
+                    alignas (32) float start[chunkSize], logDecay[chunkSize] {}, guardedSum[chunkSize] {};
+
+                    std::copy (hd + n0, hd + n0 + count, start);
+
+                    for (int64_t t = 0; t < s.length; ++t)
+                    {
+                        const auto row = b * s.length + t;
+                        const float* Bt = B + row * s.states + n0;
+                        const float* Ct = C + row * s.states + n0;
+                        const auto dt = fastmath::softplus (delta[row * s.inner + d]);
+                        const auto du = dt * x[row * s.inner + d];
+                        alignas (32) float decay[chunkSize];
+
+                        for (int i = 0; i < count; ++i)
+                            decay[i] = dt * a[n0 + i];
+
+                        if (t > 0)
+                            for (int i = 0; i < count; ++i)
+                                decay[i] = logDecay[i] += decay[i];
+
+                        fastmath::exp<> (decay, decay, count);
+
+                        if (t == 0)
+                        {
+                            for (int i = 0; i < count; ++i)
+                            {
+                                start[i] *= decay[i];
+                                decay[i] = 1.0f;
+                            }
+                        }
+
+                        float acc = 0.0f;
+
+                        for (int i = 0; i < count; ++i)
+                        {
+                            guardedSum[i] += du * Bt[i] / (decay[i] + guard);
+                            const auto next = decay[i] * guardedSum[i] + decay[i] * start[i];
+                            hd[n0 + i] = next;
+                            acc += next * Ct[i];
+                        }
+
+                        y[row * s.inner + d] += acc;
+                    }
+                }
+            }
+        }
+    }
+};
+
+struct SelectiveScanOp : Ort::CustomOpBase<SelectiveScanOp, SelectiveScanKernel>
+{
+    static constexpr const char* domain = "neural";
+
+    void* CreateKernel (const OrtApi&, const OrtKernelInfo*) const   { return new SelectiveScanKernel(); }
+    const char* GetName() const                                     { return "SelectiveScan"; }
+    const char* GetExecutionProviderType() const                    { return "CPUExecutionProvider"; }
+
+    size_t GetInputTypeCount() const                                { return 6; }
+    ONNXTensorElementDataType GetInputType (size_t) const           { return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; }
+    size_t GetOutputTypeCount() const                               { return 2; }
+    ONNXTensorElementDataType GetOutputType (size_t) const          { return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; }
+};
+
+// The "neural" domain with the operator in it, for the lifetime of the
+// process; sessions only refer to it
+inline Ort::CustomOpDomain& getSelectiveScanDomain()
+{
+    static SelectiveScanOp op;
+    static Ort::CustomOpDomain domain = []
+    {
+        Ort::CustomOpDomain created (SelectiveScanOp::domain);
+        created.Add (&op);
+        return created;
+    }();
+
+    return domain;
+}
+
+} // namespace neural
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    StateArena.h
+
+    Storage for the recurrent states a processor carries between blocks, in
+    one aligned allocation with two halves. The ONNX Runtime path reads a
+    block's states from the current half and has the session write the new
+    ones straight into the other half (through IoBinding), then swaps the
+    halves' roles, so nothing is copied or allocated per block. The native
+    kernels update the current half in place.
+
+    Each slot holds one state tensor for every channel, the channels back to
+    back, so a slot is also a valid batch-first view of all of them. A slot
+    can be larger than what the model takes back in (new_states1 returns
+    every inner channel's scan rows, states1 only takes the first); the
+    input tensor then views the start of each channel's part.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+class StateArena
+{
+public:
+    static constexpr size_t alignment = 64;     // bytes; every slot starts on a cache line
+
+    // Declares a slot of sizePerChannel floats per channel, before allocate().
+    // Returns its index.
+    int addSlot (int sizePerChannel)
+    {
+        slots.push_back ({ 0, (size_t) sizePerChannel });
+        return (int) slots.size() - 1;
+    }
+
+    // Lays the slots out for numChannels and zeroes both halves. Allocates, so
+    // call it from prepareToPlay, not from the audio thread.
+    void allocate (int numChannelsToUse)
+    {
+        numChannels = numChannelsToUse;
+        halfSize = 0;
+
+        for (auto& slot : slots)
+        {
+            slot.offset = halfSize;
+            halfSize += roundUp (slot.size * (size_t) numChannels);
+        }
+
+        storage.assign (2 * halfSize + floatsPerLine, 0.0f);
+
+        const auto misalignment = reinterpret_cast<std::uintptr_t> (storage.data()) % alignment;
+        base = storage.data() + (misalignment == 0 ? 0 : (alignment - misalignment) / sizeof (float));
+        currentHalf = 0;
+    }
+
+    // Same slots, channels and contents, for snapshots of the states
+    void allocateLike (const StateArena& other)
+    {
+        slots = other.slots;
+        allocate (other.numChannels);
+        copyFrom (other);
+    }
+
+    // Both halves and which one is current; the layouts must match. Never allocates.
+    void copyFrom (const StateArena& other)
+    {
+        std::copy (other.base, other.base + 2 * halfSize, base);
+        currentHalf = other.currentHalf;
+    }
+
+    void clear()
+    {
+        std::fill (base, base + 2 * halfSize, 0.0f);
+        currentHalf = 0;
+    }
+
+    float* get (int half, int slot, int channel) const
+    {
+        return base + (size_t) half * halfSize + slots[(size_t) slot].offset + (size_t) channel * slots[(size_t) slot].size;
+    }
+
+    float* current (int slot, int channel) const    { return get (currentHalf, slot, channel); }
+    float* next (int slot, int channel) const       { return get (1 - currentHalf, slot, channel); }
+
+    int getCurrentHalf() const                      { return currentHalf; }
+    int getNumChannels() const                      { return numChannels; }
+    size_t getSlotSize (int slot) const             { return slots[(size_t) slot].size; }
+
+    // Call once the session has written the next half
+    void swap()                                     { currentHalf = 1 - currentHalf; }
+
+private:
+    struct Slot
+    {
+        size_t offset, size;
+    };
+
+    static constexpr size_t floatsPerLine = alignment / sizeof (float);
+
+    static size_t roundUp (size_t size)             { return (size + floatsPerLine - 1) / floatsPerLine * floatsPerLine; }
+
+    std::vector<Slot> slots;
+    std::vector<float> storage;
+    float* base = nullptr;
+    size_t halfSize = 0;
+    int numChannels = 0;
+    int currentHalf = 0;
+};
+
+} // namespace neural
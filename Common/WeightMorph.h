@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    WeightMorph.h
+
+    Blends two trained weight sets of the same native model, so a single
+    inference morphs between them instead of running both models and
+    crossfading their audio. Every array of the Weights aggregate (as listed
+    by visitArrays()) is interpolated linearly; the recurrent decays stay
+    negative, so any blend of two stable models is stable too.
+
+    The morph position is quantised to NumSteps intervals and every blended
+    set is computed up front, so picking one on the audio thread is a lookup.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace neural
+{
+
+//==============================================================================
+template <typename Weights, int NumSteps>
+class WeightMorph
+{
+public:
+    static constexpr int numSets = NumSteps + 1;
+
+    // Fills every step from 'from' (position 0) to 'to' (position 1). Allocates,
+    // so call it when loading, not from the audio thread.
+    void build (const Weights& from, const Weights& to)
+    {
+        sets.resize (numSets);
+
+        const auto fromArrays = listArrays (from);
+        const auto toArrays = listArrays (to);
+
+        for (int step = 0; step < numSets; ++step)
+        {
+            const auto amount = (float) step / (float) NumSteps;
+            const auto setArrays = listArrays (sets[(size_t) step]);
+
+            for (size_t i = 0; i < setArrays.size(); ++i)
+            {
+                // The sets are ours and not const; visitArrays only hands out const views
+                auto* blended = const_cast<float*> (setArrays[i].first);
+
+                for (int n = 0; n < setArrays[i].second; ++n)
+                    blended[n] = (1.0f - amount) * fromArrays[i].first[n] + amount * toArrays[i].first[n];
+            }
+        }
+    }
+
+    bool isReady() const                        { return ! sets.empty(); }
+
+    // The precomputed set nearest to a position in [0, 1]
+    const Weights& get (float position) const
+    {
+        const auto step = (int) std::lround ((position < 0.0f ? 0.0f : (position > 1.0f ? 1.0f : position)) * NumSteps);
+        return sets[(size_t) step];
+    }
+
+private:
+    std::vector<Weights> sets;
+
+    static std::vector<std::pair<const float*, int>> listArrays (const Weights& weights)
+    {
+        std::vector<std::pair<const float*, int>> arrays;
+        weights.visitArrays ([&] (const float* data, int size) { arrays.emplace_back (data, size); });
+        return arrays;
+    }
+};
+
+} // namespace neural
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    TapePreampLstmWeights.h
+
+    Generated by Tools/GenerateModelHeader.cpp from CL1BTapePreamp__lstm_8.onnx.
+    Do not edit; re-run the tool after retraining the model.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../../../Common/LstmFilmModel.h"
+
+namespace generated::tapePreampLstm
+{
+
+using Model = neural::TapePreampLstmModel;
+
+// 537 values, in Model::Weights::visitArrays order
+inline constexpr Model::Weights weights
+{
+    -0.48359343f, 0.62579125f, 0.39740556f, 0.06290781f, -0.33276585f, 0.2671761f, -1.1800646f, -1.4314374f,
+    0.15674765f, 0.07618576f, 0.5743114f, 0.5962465f, -0.11091041f, 0.47074497f, -0.9499096f, -0.8177369f,
+    -0.66436183f, -0.23802063f, 0.33124205f, 0.88724476f, -0.80289346f, -0.6800156f, -0.39186233f, -0.9836934f,
+    -0.033495553f, 0.31693873f, -0.42418015f, -1.3584406f, 3.0208023f, 0.5985401f, -0.9915658f, -2.22151f,
+
+    0.23636928f, 0.31850874f, -0.070317246f, -1.1601144f, -0.15414287f, -0.052750006f, 0.42483914f, -0.15479057f,
+    0.09159194f, -0.25859603f, 0.12591356f, -0.6192745f, -0.28660163f, -0.27989063f, -0.11569018f, -0.095782176f,
+    -0.1971736f, -0.3682427f, -0.3897638f, 0.32910526f, 0.03770919f, -0.01989468f, -0.13946787f, 0.10777108f,
+    0.31810892f, -0.065725036f, 0.21773781f, 0.08122742f, -0.046655353f, -0.19734235f, -0.03755561f, -0.23807397f,
+    -0.22213449f, 0.31005344f, 0.38553888f, 0.7798116f, 0.97873235f, 0.5811216f, 0.24454144f, -0.26003054f,
+    -0.035059627f, 0.3002402f, 0.31680498f, 0.7257589f, 0.8356714f, 0.64823467f, 0.35953128f, -0.14847489f,
+    0.21780692f, 0.94474226f, 0.6205363f, -0.23021875f, 0.24188885f, 0.25042197f, 0.33396706f, -0.94450384f,
+    -0.37167782f, 0.36781216f, -0.30015028f, -0.37375525f, -0.16212247f, -0.18441808f, -0.020852217f, -0.10775236f,
+    -0.0494818f, 0.0409005f, -0.11661053f, -0.8949024f, -0.9607173f, -0.2750304f, 0.2612337f, -0.15147637f,
+    -0.018148886f, -0.021344662f, 0.050001286f, -0.7219771f, -0.6860348f, -0.30992687f, -0.27706966f, -0.121677734f,
+    -0.3279158f, -0.5617633f, -0.35396197f, -0.061866857f, -0.25816453f, -0.120966405f, -0.20536567f, -0.052864097f,
+    0.20633586f, -0.14773107f, 0.04116694f, 0.03604367f, -0.1645615f, -0.17486587f, -0.003387316f, -0.09984303f,
+    0.7453295f, -0.35002092f, -0.1884304f, -0.35360175f, -0.19220234f, -0.346585f, -0.37349933f, 1.0381979f,
+    0.4301351f, -0.0047915345f, 0.2652211f, -0.30480003f, 0.02197319f, -0.20688678f, -0.2914844f, 0.6073375f,
+    0.5678681f, -0.32926026f, 0.11280683f, -0.555559f, 0.3618505f, 0.29715052f, -0.82389355f, 1.0228207f,
+    -0.15325578f, -0.30250213f, 0.08126275f, -0.31023762f, -0.5393409f, -0.2897592f, -0.51609164f, 0.31738198f,
+    -0.30329216f, 0.3668867f, -0.27636337f, -0.361001f, -0.6057398f, -0.23785082f, 0.2084617f, -0.16278549f,
+    -0.14698876f, -0.2809536f, 0.048422825f, -0.09367178f, -0.72545385f, -0.5319274f, -0.10228138f, -0.35560203f,
+    -0.32770327f, -0.366626f, -0.27649623f, 0.12415709f, -0.35829774f, -0.16260652f, 0.0954396f, 0.09155501f,
+    0.27461553f, -0.016196635f, 0.4084564f, -0.0070811603f, -0.06370503f, 0.29102993f, 0.14962822f, -0.12585366f,
+    -0.5345866f, 0.33160794f, -0.0048644426f, -0.032629382f, -0.09685468f, 0.07380505f, -0.3989639f, 0.042212903f,
+    -0.1868081f, -0.15570396f, 0.056143567f, 0.38923126f, -0.40943494f, 0.021502644f, -0.20144942f, -0.16614081f,
+    -0.35003743f, 0.027529523f, 0.16090035f, 0.7819687f, 0.25818172f, -0.061513472f, 0.011363929f, 0.3004471f,
+    0.093551844f, -0.25931767f, -0.020122007f, 0.22103915f, 0.08436734f, 0.042032268f, 0.3153448f, 0.26251528f,
+    -0.052193746f, -0.070788726f, -0.05330207f, 1.0956931f, 0.6254926f, 0.16080213f, 0.23364347f, 0.4675853f,
+    0.24374396f, 0.35845104f, 0.31874725f, 0.65298504f, 0.22039454f, 0.11284276f, 0.55407876f, 0.40872845f,
+    0.082578115f, 0.6023689f, 0.051866412f, -0.2656181f, -0.28106597f, -0.21784915f, 0.5428737f, 0.07514688f,
+    -0.3292354f, 0.059368573f, 0.08723308f, -0.106362194f, -0.20191912f, -0.1255951f, 0.34146628f, 0.42800948f,
+    -0.21932074f, -0.34051034f, 0.4345838f, 1.2463437f, 1.050292f, 0.90111125f, -0.14671029f, -0.13865142f,
+    0.011639015f, 0.37668544f, 0.093509056f, 0.83124083f, 1.3859622f, 1.2795473f, -0.01739292f, 0.07830106f,
+    0.04161893f, 0.47163367f, 0.53837985f, -0.0039444542f, -0.081590265f, 0.29677892f, -0.11484931f, -0.22915466f,
+    -0.63088256f, 0.07260497f, -0.26074108f, -0.009396072f, -0.13669574f, 0.0714689f, 0.16332181f, 0.20864323f,
+
+    0.11247993f, -0.14742757f, 0.21690683f, 1.1964505f, 1.6164347f, 0.5209122f, -0.06982097f, 0.6385468f,
+    -0.19706385f, 0.49028927f, 0.22779986f, 1.7991498f, 1.33373f, 0.58666646f, 0.48014364f, 0.9813024f,
+    0.6601025f, 1.1861337f, 0.4209093f, -0.06519398f, -0.108032614f, 0.09279856f, 0.920123f, 0.31879577f,
+    -0.1016936f, -0.04536424f, -0.30380693f, 0.16412015f, 0.012298167f, 0.040832225f, -0.06801146f, 0.040439278f,
+
+    0.40567937f, -0.4023861f, -0.48459572f, 1.2838455f, -0.27652225f, -1.3400853f, 0.13238326f, -1.0285037f,
+    0.042676646f, -0.31737864f, 0.866538f, -0.14216888f, 0.16620861f, 0.31469965f, -0.8025073f, 0.66446364f,
+    0.050283078f, -2.770169f, -0.7722507f, -0.61080897f, 0.2875409f, -1.2474774f, 2.0096788f, -0.60780936f,
+    -0.9489104f, -0.7501199f, 0.3046921f, -0.7734046f, -0.09476335f, 0.1764627f, 0.08045962f, 0.15559942f,
+    -0.5125852f, -0.11279714f, 0.29699874f, 0.33366498f, -1.2208138f, 0.66286194f, 0.30588725f, 0.5741069f,
+    0.27925736f, 0.123293094f, -0.3134491f, 0.2039371f, -0.2015884f, 0.15257461f, 0.038173683f, 0.004772828f,
+
+    -0.00515882f, -0.26932317f, -0.14320265f, 0.59278524f, -0.46698847f, 0.71871597f, 0.2832069f, 0.34932482f,
+    0.13839637f, 0.14957745f, -0.36949953f, -0.12378097f, -0.059920546f, 0.35236296f, 0.044798646f, 0.29443222f,
+
+    0.07406326f, -0.011450884f, -0.33325905f, 0.32849383f, -0.1468301f, 0.3113673f, -0.31581664f, 0.050092693f,
+    0.22920877f, 0.29102084f, 0.07585334f, 0.20770183f, -0.26287445f, 0.045310866f, 0.12808461f, -0.030810637f,
+    -0.14665875f, -0.1957954f, -0.09362623f, 0.4370454f, -0.093776986f, 0.29826844f, -0.27602232f, 0.15912859f,
+    0.37757888f, 0.08620094f, 0.31239793f, 0.15421598f, -0.3048351f, -0.35863835f, -0.24643703f, -0.112366386f,
+    -0.03686462f, -0.19963199f, 0.45818517f, -0.06602639f, -0.15412329f, 0.10707161f, 0.17001815f, -0.15149947f,
+    -0.33393008f, -0.120594434f, -0.13516824f, 0.043885328f, 0.4423889f, 0.18488267f, -0.031995885f, -0.045940567f,
+    0.047581546f, 0.16331439f, -0.3553916f, -0.28238118f, -0.24073705f, 0.10991339f, 0.17194203f, 0.22450063f,
+    0.1328958f, -0.0016470527f, -0.19451314f, 0.31925073f, 0.01360644f, 0.431924f, -0.17689079f, -0.11823667f,
+    0.6888322f, 0.43282622f, 0.033181943f, -0.14104187f, -0.9196921f, -0.395984f, 0.40732142f, 0.121047124f,
+    0.21705012f, 0.26363677f, 0.19967438f, -0.028270165f, -0.083115764f, 0.30907005f, -0.17864731f, 0.17417602f,
+    -0.21795496f, -0.28840694f, -0.37372983f, 0.078498475f, 0.63860404f, 0.34948915f, -0.15063629f, 0.23651844f,
+    0.55582213f, 0.09046134f, -0.15679657f, -0.2649741f, -0.34241757f, -0.38536254f, 0.38733378f, 0.32126328f,
+    0.08724157f, 0.18823895f, -0.49467456f, -0.40248486f, -0.05180447f, -0.4019687f, 0.04732494f, -0.31812382f,
+    0.064018615f, 0.1791744f, 0.048870414f, 0.033539027f, 0.094479464f, 0.15840903f, -0.09833343f, -0.0384814f,
+    0.4069779f, 0.050195783f, -0.17266154f, -0.1233135f, -0.04897237f, 0.006398936f, 0.14611316f, -0.014538951f,
+    0.36609584f, 0.404448f, 0.432681f, -0.1325159f, -0.06917528f, 0.14751339f, -0.0037104883f, -0.20242919f,
+
+    0.085133344f, 0.13588446f, -0.056830406f, 0.015528366f, 0.18829791f, 0.1254844f, -0.0068133334f, -0.1367383f,
+    0.32713905f, 0.21313837f, 0.14860488f, -0.19453938f, -0.26171446f, -0.30277118f, 0.2183461f, -0.15545617f,
+
+    -0.49952996f, -0.37949368f, 0.434577f, -0.038288556f, -0.26636246f, -0.42416075f, -0.219978f, -0.08433788f,
+
+    -0.015638983f,
+};
+
+inline void process (const float* input, const float* const* conditioning,
+                     float* output, int numSamples, float* h, float* c)
+{
+    Model::run (weights, input, conditioning, output, numSamples, h, c);
+}
+
+} // namespace generated::tapePreampLstm
@@ -58,6 +58,18 @@ HybridAudioProcessorEditor::HybridAudioProcessorEditor (HybridAudioProcessor& p)
 
     addAndMakeVisible(pLabel);
     
+    // Set up inference engine toggle, naming the instruction set the native kernels run on
+    nativeButton.setButtonText("Native engine (" + juce::String(neural::getSimdLevelName(audioProcessor.getSimdLevel())) + ")");
+    nativeButton.setToggleState(audioProcessor.getInferenceBackend() == neural::InferenceBackend::native,
+                                juce::dontSendNotification);
+    nativeButton.setColour(juce::ToggleButton::textColourId, juce::Colours::deepskyblue);
+    nativeButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::deepskyblue);
+    nativeButton.addListener(this);
+    addAndMakeVisible(nativeButton);
+   #if ! NEURAL_USE_ONNXRUNTIME
+    nativeButton.setEnabled(false); // native-only build, nothing to switch to
+   #endif
+    
     // Create the attachment - this connects the slider to the parameter
     cAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getParameters(), "c", cSlider);
@@ -71,11 +83,14 @@ HybridAudioProcessorEditor::HybridAudioProcessorEditor (HybridAudioProcessor& p)
 
 HybridAudioProcessorEditor::~HybridAudioProcessorEditor()
 {
+    nativeButton.removeListener(this);
 }
 
 void HybridAudioProcessorEditor::buttonClicked (juce::Button* button)
 {
-
+    if (button == &nativeButton)
+        audioProcessor.setInferenceBackend(nativeButton.getToggleState() ? neural::InferenceBackend::native
+                                                                         : neural::InferenceBackend::onnxRuntime);
 }
 
 
@@ -100,5 +115,6 @@ void HybridAudioProcessorEditor::resized()
     cSlider.setBounds(50, 80, 100, 150);
     tSlider.setBounds(150, 80, 100, 150);
     pSlider.setBounds(250, 80, 100, 150);
+    nativeButton.setBounds(190, 260, 200, 30);
     
 }
@@ -41,6 +41,8 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> cAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> pAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> tAttachment;
+    
+    juce::ToggleButton nativeButton { "Native engine" };
    
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HybridAudioProcessorEditor)
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    CL1BWeights.h
+
+    Generated by Tools/GenerateModelHeader.cpp from CL1B_nof.onnx.
+    Do not edit; re-run the tool after retraining the model.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../NativeCL1BModel.h"
+
+namespace generated::cl1b
+{
+
+using Model = NativeCL1BModel<6, 4>;
+
+// 461 values, in Model::Weights::visitArrays order
+inline constexpr Model::Weights weights
+{
+    0.7944938f, 0.91819775f,
+
+    -0.021892857f, 0.15106851f,
+
+    0.68544066f, -0.8792215f, 0.06490161f, -0.80688894f, 0.5226947f, 1.2022967f, 0.844152f, 0.71361506f,
+    -0.33641598f, -0.4053854f, -0.8690418f, -0.31180528f, -0.6559428f, 0.8675431f, 0.54595786f, 0.9987818f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+    0.53113514f, -0.47137818f, -0.3852213f, 0.13625173f, 0.83001745f, 0.6695699f, -0.032851644f, 0.8831912f,
+    0.017396374f, -0.13472095f, -0.344449f, -0.58081925f, 0.008050882f, 0.71125895f, 0.22372259f, 0.7641026f,
+
+    -0.047057293f, 0.36365917f, 0.27485216f, 0.2502541f,
+
+    -1.000004f, -0.99999464f, -0.9999966f, -0.9999979f, -1.0000147f, -1.0000066f, -0.93931884f, -1.0549481f,
+    -1.0622402f, -0.96315014f, -1.017862f, -0.96737957f, -1.0013727f, -1.0023253f, -0.9990009f, -0.9999325f,
+    -0.994897f, -0.99753267f, -0.9731584f, -1.02544f, -1.0295444f, -0.98522496f, -1.0030036f, -0.98444396f,
+
+    1.0026941f, 1.3694696f, 1.1830108f, 1.3287878f,
+
+    0.027549172f, 0.42862272f, 0.45542744f, -0.3200046f, 0.3283912f, 0.26550472f, -0.25684625f, -0.15804605f,
+    -0.5737647f, -0.4480741f, -0.43932033f, -0.17937844f, -0.011182205f, 0.50834614f, 0.043831576f, 0.44812664f,
+    0.4997459f, -0.39957514f, 0.3383779f, -0.29456314f, -0.50255316f, -0.07631666f, -0.4191197f, -0.15578985f,
+    -0.44959515f, -0.24223305f, -0.34399682f, -0.48417392f, 0.30598047f, 0.13193266f, -0.018699996f, 0.32349843f,
+    0.43713754f, -0.43838245f, 0.2838249f, -0.16137375f, 0.41306648f, 0.41849557f, -0.021800978f, 0.06383201f,
+    -0.6308493f, 0.2630312f, 0.1438866f, 0.22812676f, -0.23317817f, -0.39340183f, -0.1556104f, -0.14346227f,
+    0.30984995f, -0.44156224f, 0.62802744f, 0.005025169f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+    0.359403f, 1.0254099f, 0.08716772f, -0.6689539f,
+
+    5.105218e-06f, -0.02319244f, -0.00055577303f, -0.0077713365f,
+
+    0.18599045f, 0.66991276f, -1.1113365f, 0.97186476f, 1.054967f, -0.16692999f, -1.0824805f, 0.34231114f,
+
+    0.36963013f, -0.07773705f,
+
+    0.41434368f, -0.44424543f, -0.24379209f, -0.42994457f,
+
+    0.5251256f, -0.1413462f,
+
+    -0.64526093f, 0.9680147f, -1.0873331f, -1.2443235f, -0.86657727f, -0.64207244f, 0.20229629f, -0.03356627f,
+
+    -0.23798977f, -0.00820392f, -0.24930412f, -0.22750784f,
+
+    0.06757015f, -0.89264923f, 0.68935543f, -0.5723547f, 0.4296554f, -1.2447238f, -0.59507483f, -0.3361789f,
+
+    0.031540815f, 0.24221273f, 0.10009622f, 0.31552973f,
+
+    0.5962038f, -0.5490983f, 0.035944708f, 0.48543528f, -0.19805558f, -1.0228566f, 0.41851804f, -0.32359308f,
+    0.5468685f, 0.2663464f, 1.0161275f, 0.07056859f, 0.16232362f, 0.16978537f, 0.027062895f, -0.59338087f,
+    0.2216559f, -0.19293953f, 0.32915857f, -0.65281266f, 0.45070538f, -0.61343974f, 0.5885084f, -0.047358315f,
+
+    -0.0019016545f, 0.5258996f, -0.33794305f, -0.17592014f, -0.18988611f, -0.100335404f, 0.7819354f, 0.5686343f,
+    0.2644257f, 0.080630176f, 0.51616895f, 0.56420815f, -0.44813594f, -0.19930178f, 0.3191568f, -0.19687659f,
+    -0.41569567f, 0.13593188f, -0.772521f, 0.05364855f, 0.25848946f, 0.51762986f, -0.6360838f, 0.07907796f,
+    0.14281163f, 0.33646336f, 0.028151892f, 0.009063616f, 0.80558276f, 0.23865673f, 0.62247825f, 0.00839618f,
+    0.5708157f, -0.55075747f, 0.65797424f, 0.61098546f, 0.27013585f, 0.2754928f, 0.041145142f, 0.018455207f,
+    -0.15531895f, 0.05496758f, 0.49870026f, 0.00015449933f, 0.6673035f, -0.755987f, 0.41146117f, -0.24248563f,
+
+    -0.0025256583f, -0.0091599105f, -0.00023546975f, -0.002789832f, 0.23607184f, 0.18157281f, 0.66375226f, 0.14050761f,
+    0.28190365f, -0.14482673f, 0.6959416f, 0.19043909f,
+
+    -0.0025256583f, -0.0091599105f, -0.00023546975f, -0.002789832f, 0.23607184f, 0.18157281f, 0.66375226f, 0.14050761f,
+    0.28165618f, -0.3197581f, 0.69857776f, 0.21978115f,
+
+    0.42273557f, 1.054844f, 1.152016f, -0.97050035f, 1.2686768f, 0.34387383f, 0.7225197f, -0.41266677f,
+
+    0.06884053f, 0.10912696f, 0.32172635f, -0.16580135f,
+
+    0.72048146f, -0.73094606f, -0.5786691f, -1.021995f, -0.94524956f, 0.027259326f, -0.21030556f, -0.098280534f,
+    -0.18542081f, 0.8519519f, 0.8332845f, -0.28973588f, 0.13766062f, -0.7313882f, 0.25403386f, 0.94970965f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+    -0.5219572f, -0.5855811f, 0.08412811f, -0.4140693f, -0.5438416f, -0.5208171f, 0.20596106f, -0.64005417f,
+    -0.18582839f, 0.45511103f, 0.3486154f, 0.6485542f, 0.5115171f, -0.119227745f, 0.57304114f, 0.8131838f,
+
+    -0.18935183f, 0.12493587f, -0.24938223f, -0.03705579f,
+
+    -0.9270421f, -0.98823184f, -1.013656f, -1.0181876f, -0.98737496f, -1.0261172f, -0.82463527f, -0.9016192f,
+    -1.09992f, -1.0635287f, -1.0614891f, -1.0861195f, -0.90690106f, -0.97425437f, -1.0278493f, -1.050091f,
+    -0.9962056f, -1.0084096f, -1.0690811f, -0.93133503f, -0.87518275f, -0.9583174f, -0.69309425f, -0.9662939f,
+
+    1.2384377f, 1.1237137f, 1.1344558f, 1.424361f,
+
+    -0.34507823f, 0.04028268f, -0.30417725f, 0.17989764f, -0.61667466f, -0.0034613248f, -0.40302077f, 0.02539406f,
+    0.24419226f, 0.15607531f, -0.567393f, 0.19766662f, -0.019785633f, -1.139462f, 0.81403875f, 0.13688944f,
+    -0.48575297f, 0.32166305f, -0.6890239f, 0.24241357f, -0.09226139f, -0.6140228f, -0.018368907f, 0.102707036f,
+    0.14413135f, -0.51618284f, -0.32711405f, -0.8858507f, 0.3234852f, 0.469455f, -0.33355507f, -0.17690477f,
+    -0.3154403f, 0.020222716f, 0.48139852f, 0.35864964f, -0.6139772f, 0.3139745f, -0.46011144f, 0.08550973f,
+    -0.17503095f, 0.5680491f, 0.5103442f, 0.32459602f, 0.110327736f, -0.2267192f, -0.7767844f, 0.062741555f,
+    -0.1603451f, 0.2686432f, 0.19462025f, -0.4911719f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+    -0.22423564f, -0.8239706f, -0.69598234f, 1.0394506f,
+
+    0.0540853f, 0.36924416f, 0.064113565f, -0.32422113f,
+
+    -1.0458382f, -0.07678016f, -0.6490943f, -0.061540164f, 0.8238003f, -0.49316132f, -1.2245319f, -1.1661404f,
+
+    -0.06695365f, -0.070858054f,
+
+    -0.22622411f, 0.24241337f, -0.9535661f, 0.89093375f,
+
+    0.04594745f, -0.12524147f,
+
+    0.8813734f, -1.2683818f,
+
+    0.069096066f,
+};
+
+inline void process (const float* input,
+                     const float* threshold, const float* ratio,
+                     const float* attack, const float* release,
+                     float* output, int numSamples,
+                     float* states1, float* states2, float* hidden,
+                     float* stream1 = nullptr, float* stream2 = nullptr)
+{
+    Model::run (weights, input, threshold, ratio, attack, release, output, numSamples,
+                states1, states2, hidden, stream1, stream2);
+}
+
+} // namespace generated::cl1b
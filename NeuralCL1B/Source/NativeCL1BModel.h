@@ -0,0 +1,332 @@
+/*
+  ==============================================================================
+
+    NativeCL1BModel.h
+
+    Built-in implementation of CL1B_nof.onnx: two selective-scan (Mamba)
+    blocks around a FiLM / temporal-FiLM conditioning stage. It reads the
+    weights from the same .onnx file as the ONNX Runtime session and exchanges
+    the same states1 / states2 / hidden vectors, without any per-call dispatch
+    or allocation. Each call computes what one Run() of the graph does, the
+    scan's 1e-12 guard included (see SelectiveScanBlock).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../../Common/NeuralLayers.h"
+#include "../../Common/ParallelScan.h"
+
+//==============================================================================
+template <int StateSize, int FilmHiddenSize, int InnerSize = 4, int ModelSize = 2>
+class NativeCL1BModel
+{
+public:
+    static constexpr int convKernelSize = 4;
+    static constexpr int numFilmParams = 2;
+    static constexpr int numTemporalParams = 2;
+
+    using ScanBlock = neural::SelectiveScanBlock<ModelSize, InnerSize, StateSize, convKernelSize>;
+
+    static_assert (FilmHiddenSize == 2 * ModelSize, "The temporal FiLM hidden state holds gamma and beta");
+
+    struct Weights
+    {
+        neural::Dense<1, ModelSize> initialDense;
+        ScanBlock mamba1;
+        neural::Dense<ModelSize, ModelSize> dense1;
+        neural::Dense<numFilmParams, 2 * ModelSize> film;
+        neural::SoftsignGlu<ModelSize> filmGlu;
+        neural::GruCell<numTemporalParams, FilmHiddenSize> temporalGru;
+        neural::SoftsignGlu<ModelSize> temporalGlu;
+        ScanBlock mamba2;
+        neural::Dense<ModelSize, ModelSize> dense2;
+        neural::Dense<ModelSize, 1> outLayer;
+
+        template <typename Visitor>
+        void visitArrays (Visitor&& visit) const
+        {
+            initialDense.visitArrays (visit);
+            mamba1.visitArrays (visit);
+            dense1.visitArrays (visit);
+            film.visitArrays (visit);
+            filmGlu.visitArrays (visit);
+            temporalGru.visitArrays (visit);
+            temporalGlu.visitArrays (visit);
+            mamba2.visitArrays (visit);
+            dense2.visitArrays (visit);
+            outLayer.visitArrays (visit);
+        }
+    };
+
+    bool load (const std::string& modelPath)
+    {
+        neural::OnnxInitializers initializers;
+
+        return initializers.loadFromFile (modelPath) && load (initializers);
+    }
+
+    bool load (const neural::OnnxInitializers& w)
+    {
+        return weights.initialDense.load (w, "onnx::MatMul_411", "initial_dense.bias")
+            && weights.mamba1.load (w, { "onnx::MatMul_412", "mamba1.conv1d.weight", "mamba1.conv1d.bias",
+                                         "onnx::Exp_421", "onnx::Mul_422", "onnx::MatMul_423",
+                                         "onnx::MatMul_424", "mamba1.delta_t_projection.bias",
+                                         "onnx::MatMul_434", "mamba1.out_projection.bias" })
+            && weights.dense1.load (w, "onnx::MatMul_435", "dense1.bias")
+            && weights.film.load (w, "onnx::MatMul_436", "film.dense.bias")
+            && weights.filmGlu.load (w, "onnx::MatMul_437", "film.glu.dense.bias")
+            && weights.temporalGru.load (w, "onnx::GRU_455", "onnx::GRU_456", "onnx::GRU_457")
+            && weights.temporalGlu.load (w, "onnx::MatMul_458", "temporal_film.glu.dense.bias")
+            && weights.mamba2.load (w, { "onnx::MatMul_459", "mamba2.conv1d.weight", "mamba2.conv1d.bias",
+                                         "onnx::Exp_468", "onnx::Mul_469", "onnx::MatMul_470",
+                                         "onnx::MatMul_471", "mamba2.delta_t_projection.bias",
+                                         "onnx::MatMul_481", "mamba2.out_projection.bias" })
+            && weights.dense2.load (w, "onnx::MatMul_482", "dense2.bias")
+            && weights.outLayer.load (w, "onnx::MatMul_483", "out_layer.bias");
+    }
+
+    // Runs one block for one channel. The state pointers are the same
+    // [StateSize] / [FilmHiddenSize] vectors that are fed to and read back
+    // from the ONNX session, and are updated in place. output may alias input.
+    // stream1 / stream2 ([ScanBlock::streamStateSize] each) carry the conv
+    // history and the rest of the scan state across blocks, so the result does
+    // not depend on the block size; pass nullptr to restart every block from
+    // the carried states alone, like the stock export.
+    void process (const float* input,
+                  const float* threshold, const float* ratio,
+                  const float* attack, const float* release,
+                  float* output, int numSamples,
+                  float* states1, float* states2, float* hidden,
+                  float* stream1 = nullptr, float* stream2 = nullptr) const
+    {
+        run (weights, input, threshold, ratio, attack, release, output, numSamples,
+             states1, states2, hidden, stream1, stream2);
+    }
+
+    const Weights& getWeights() const   { return weights; }
+
+    // The same, for weights that do not live in a model object, e.g. the
+    // constexpr ones in a header written by Tools/GenerateModelHeader.cpp.
+    // Ops picks the instruction set (see CpuDispatch.h).
+    template <typename Ops = neural::fastmath::NativeOps>
+    static void run (const Weights& w, const float* input,
+                     const float* threshold, const float* ratio,
+                     const float* attack, const float* release,
+                     float* output, int numSamples,
+                     float* states1, float* states2, float* hidden,
+                     float* stream1 = nullptr, float* stream2 = nullptr)
+    {
+        runInterleaved<1, Ops> (w, &input, threshold, ratio, attack, release, &output, numSamples,
+                                &states1, &states2, &hidden,
+                                stream1 != nullptr ? &stream1 : nullptr,
+                                stream2 != nullptr ? &stream2 : nullptr);
+    }
+
+    // Runs Channels channels (e.g. left and right) in one pass, their values
+    // interleaved so that every step advances all of them together. Each
+    // per-channel argument is an array of Channels pointers, laid out as for
+    // run(); the controls are shared. Each channel's result is the same as
+    // running it on its own, to within the rounding of the wider SIMD blocks.
+    template <int Channels, typename Ops = neural::fastmath::NativeOps>
+    static void runInterleaved (const Weights& w, const float* const* inputs,
+                                const float* threshold, const float* ratio,
+                                const float* attack, const float* release,
+                                float* const* outputs, int numSamples,
+                                float* const* states1, float* const* states2, float* const* hiddens,
+                                float* const* stream1 = nullptr, float* const* stream2 = nullptr)
+    {
+        typename ScanBlock::template PackedState<Channels> scan1, scan2;
+        ScanBlock::loadCarriedStates (scan1, states1, stream1);
+        ScanBlock::loadCarriedStates (scan2, states2, stream2);
+
+        alignas (32) float hidden[FilmHiddenSize * Channels];
+
+        for (int k = 0; k < FilmHiddenSize; ++k)
+            for (int ch = 0; ch < Channels; ++ch)
+                hidden[k * Channels + ch] = hiddens[ch][k];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float x[Channels];
+
+            for (int ch = 0; ch < Channels; ++ch)
+                x[ch] = inputs[ch][i];
+
+            float a[ModelSize * Channels], b[ModelSize * Channels];
+
+            w.initialDense.template forward<Channels> (x, a);
+            w.mamba1.template step<Ops, Channels> (a, b, scan1);
+            condition<Channels, Ops> (w, b, a, threshold[i], ratio[i], attack[i], release[i], hidden);
+            w.mamba2.template step<Ops, Channels> (a, b, scan2);
+
+            float y[Channels];
+            finish<Channels, Ops> (w, b, a, x, y);
+
+            for (int ch = 0; ch < Channels; ++ch)
+                outputs[ch][i] = y[ch];
+        }
+
+        ScanBlock::storeCarriedStates (scan1, states1, stream1);
+        ScanBlock::storeCarriedStates (scan2, states2, stream2);
+
+        for (int k = 0; k < FilmHiddenSize; ++k)
+            for (int ch = 0; ch < Channels; ++ch)
+                hiddens[ch][k] = hidden[k * Channels + ch];
+    }
+
+    // The same result as run() (to float rounding), computed on all of the
+    // pool's threads; for offline rendering of long blocks (see ParallelScan.h).
+    // The temporal GRU is not a linear recurrence, but it only sees the
+    // controls: it runs once through the block on the calling thread to find
+    // its state at every segment start. Call it from a CpuDispatch entry for Ops.
+    template <typename Ops = neural::fastmath::NativeOps>
+    static void renderParallel (neural::TaskPool& pool, const Weights& w, const float* input,
+                                const float* threshold, const float* ratio,
+                                const float* attack, const float* release,
+                                float* output, int numSamples,
+                                float* states1, float* states2, float* hidden,
+                                float* stream1 = nullptr, float* stream2 = nullptr)
+    {
+        using State = typename ScanBlock::State;
+
+        State scan1, scan2;
+        ScanBlock::loadCarriedState (scan1, states1, stream1);
+        ScanBlock::loadCarriedState (scan2, states2, stream2);
+
+        // Long blocks go through in windows, which bounds the scratch to 2 MB
+        constexpr int maxWindow = 1 << 18;
+
+        std::vector<float> rows ((size_t) (std::min (numSamples, maxWindow) * ModelSize));
+        std::vector<float> hiddenStarts;
+        std::vector<State> starts;
+
+        for (int offset = 0; offset < numSamples; offset += maxWindow)
+        {
+            const neural::ScanSegments segments (std::min (maxWindow, numSamples - offset), pool);
+            const auto numSegments = segments.numSegments;
+
+            const float* x = input + offset;
+            float* y = output + offset;
+            float* row = rows.data();
+
+            neural::parallelFor<Ops> (pool, numSegments, [&] (int s)
+            {
+                for (int i = segments.begin (s); i < segments.end (s); ++i)
+                    w.initialDense.forward (x + i, row + i * ModelSize);
+            });
+
+            hiddenStarts.resize ((size_t) (numSegments * FilmHiddenSize));
+
+            for (int s = 0; s < numSegments; ++s)
+            {
+                std::copy (hidden, hidden + FilmHiddenSize, hiddenStarts.data() + s * FilmHiddenSize);
+
+                for (int i = offset + segments.begin (s); i < offset + segments.end (s); ++i)
+                {
+                    const float temporalParams[numTemporalParams] = { attack[i], release[i] };
+                    w.temporalGru.template step<Ops> (temporalParams, hidden);
+                }
+            }
+
+            // mamba1 and the conditioning, leaving mamba2's inputs in the rows
+            neural::findSegmentStarts<Ops> (pool, w.mamba1, row, segments, scan1, starts);
+
+            neural::parallelFor<Ops> (pool, numSegments, [&] (int s)
+            {
+                auto& state = starts[(size_t) s];
+                float* segmentHidden = hiddenStarts.data() + s * FilmHiddenSize;
+
+                for (int i = segments.begin (s); i < segments.end (s); ++i)
+                {
+                    const auto c = offset + i;
+                    float b[ModelSize];
+
+                    w.mamba1.template step<Ops> (row + i * ModelSize, b, state);
+                    condition<1, Ops> (w, b, row + i * ModelSize, threshold[c], ratio[c], attack[c], release[c], segmentHidden);
+                }
+            });
+
+            scan1 = starts.back();
+
+            // mamba2 and the output
+            neural::findSegmentStarts<Ops> (pool, w.mamba2, row, segments, scan2, starts);
+
+            neural::parallelFor<Ops> (pool, numSegments, [&] (int s)
+            {
+                auto& state = starts[(size_t) s];
+
+                for (int i = segments.begin (s); i < segments.end (s); ++i)
+                {
+                    float a[ModelSize], b[ModelSize];
+
+                    w.mamba2.template step<Ops> (row + i * ModelSize, b, state);
+                    finish<1, Ops> (w, b, a, x + i, y + i);
+                }
+            });
+
+            scan2 = starts.back();
+        }
+
+        ScanBlock::storeCarriedState (scan1, states1, stream1);
+        ScanBlock::storeCarriedState (scan2, states2, stream2);
+    }
+
+private:
+    Weights weights;
+
+    // mamba1's output b through dense1, FiLM on the static compressor controls
+    // and temporal FiLM (advancing the GRU state), into mamba2's input a. b is
+    // used as scratch.
+    template <int Channels, typename Ops>
+    static void condition (const Weights& w, float* b, float* a,
+                           float threshold, float ratio, float attack, float release, float* hidden)
+    {
+        w.dense1.template forward<Channels> (b, a);
+
+        neural::gelu<ModelSize * Channels, Ops> (a);
+
+        const float filmParams[numFilmParams] = { threshold, ratio };
+        float filmOut[2 * ModelSize];
+        w.film.forward (filmParams, filmOut);
+
+        for (int c = 0; c < ModelSize; ++c)
+            for (int ch = 0; ch < Channels; ++ch)
+                a[c * Channels + ch] = filmOut[c] * a[c * Channels + ch] + filmOut[ModelSize + c];
+
+        w.filmGlu.template forward<Channels> (a, b);
+
+        // Temporal FiLM, driven by a GRU over the time-constant controls
+        float temporalParams[numTemporalParams * Channels];
+
+        for (int ch = 0; ch < Channels; ++ch)
+        {
+            temporalParams[ch] = attack;
+            temporalParams[Channels + ch] = release;
+        }
+
+        w.temporalGru.template step<Ops, Channels> (temporalParams, hidden);
+
+        for (int c = 0; c < ModelSize * Channels; ++c)
+            b[c] = hidden[c] * b[c] + hidden[ModelSize * Channels + c];
+
+        w.temporalGlu.template forward<Channels> (b, a);
+    }
+
+    // mamba2's output b to the model's output y, scaled by the input x. a is
+    // used as scratch.
+    template <int Channels, typename Ops>
+    static void finish (const Weights& w, const float* b, float* a, const float* x, float* y)
+    {
+        w.dense2.template forward<Channels> (b, a);
+
+        neural::gelu<ModelSize * Channels, Ops> (a);
+
+        float out[Channels];
+        w.outLayer.template forward<Channels> (a, out);
+
+        for (int ch = 0; ch < Channels; ++ch)
+            y[ch] = out[ch] * x[ch];
+    }
+};
@@ -58,6 +58,18 @@ NeuralCL1BAudioProcessorEditor::NeuralCL1BAudioProcessorEditor (NeuralCL1BAudioP
     releaseLabel.setColour(juce::Label::textColourId, juce::Colours::deepskyblue);
     addAndMakeVisible(releaseLabel);
     
+    // Set up inference engine toggle, naming the instruction set the native kernels run on
+    nativeButton.setButtonText("Native engine (" + juce::String(neural::getSimdLevelName(audioProcessor.getSimdLevel())) + ")");
+    nativeButton.setToggleState(audioProcessor.getInferenceBackend() == neural::InferenceBackend::native,
+                                juce::dontSendNotification);
+    nativeButton.setColour(juce::ToggleButton::textColourId, juce::Colours::deepskyblue);
+    nativeButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::deepskyblue);
+    nativeButton.addListener(this);
+    addAndMakeVisible(nativeButton);
+   #if ! NEURAL_USE_ONNXRUNTIME
+    nativeButton.setEnabled(false); // native-only build, nothing to switch to
+   #endif
+    
     // Create parameter attachments
     thresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getParameters(), "threshold", thresholdSlider);
@@ -74,11 +86,14 @@ NeuralCL1BAudioProcessorEditor::NeuralCL1BAudioProcessorEditor (NeuralCL1BAudioP
 
 NeuralCL1BAudioProcessorEditor::~NeuralCL1BAudioProcessorEditor()
 {
+    nativeButton.removeListener(this);
 }
 
 void NeuralCL1BAudioProcessorEditor::buttonClicked (juce::Button* button)
 {
-
+    if (button == &nativeButton)
+        audioProcessor.setInferenceBackend(nativeButton.getToggleState() ? neural::InferenceBackend::native
+                                                                         : neural::InferenceBackend::onnxRuntime);
 }
 
 
@@ -100,6 +115,7 @@ void NeuralCL1BAudioProcessorEditor::paint (juce::Graphics& g)
 void NeuralCL1BAudioProcessorEditor::resized()
 {
     auto area = getLocalBounds();
+        nativeButton.setBounds(area.removeFromBottom(30).removeFromRight(200));
         area.removeFromTop(30); // Title space
         area.reduce(20, 10);    // Margins
         
@@ -45,5 +45,7 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attackAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> releaseAttachment;
     
+    juce::ToggleButton nativeButton { "Native engine" };
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NeuralCL1BAudioProcessorEditor)
 };
@@ -32,54 +32,56 @@ NeuralCL1BAudioProcessor::NeuralCL1BAudioProcessor()
                                      })
 #endif
 {
-    initializeOnnxRuntime();
+    nativeKernel = neural::SimdDispatch<NativeKernel>::select<NeuralCL1BAudioProcessor&, float* const*, int, int,
+                                                              float, float, float, float>(simdLevel);
+    outputLimiter = neural::SimdDispatch<neural::SoftLimitKernel>::select<const float*, float*, int, float>(simdLevel);
+    DBG("Native kernels: " + juce::String(neural::getSimdLevelName(simdLevel)));
+
+    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+        stateArena.addSlot(SCAN_STATE_SIZE);
+    for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+        stateArena.addSlot(STATE_SIZE_FILM);
+    for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+        stateArena.addSlot(STREAM_STATE_SIZE);
+
+    auto modelPath = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
+                        .getParentDirectory()
+                        .getParentDirectory()
+                        .getChildFile("Resources")
+                        .getChildFile("CL1B_nof.onnx")
+                        .getFullPathName();
+
+    DBG("Attempting to load model from: " + modelPath);
+
+    // The session is created once, here, off the message and audio threads
+    modelLoader.start([this, modelPath]
+    {
+        auto model = loadModel(modelPath);
+
+        const std::lock_guard<std::mutex> lock(preparationLock);
+
+       #if NEURAL_USE_ONNXRUNTIME
+        // Prepared before the model was ready: the bindings are made here
+        if (model->sessionLoaded && maxBlockSize > 0)
+        {
+            createBindings(*model, maxBlockSize);
+            sizeRealtimeArena(*model);
+        }
+       #endif
+
+        modelLoader.publish(std::move(model));
+    });
 }
 
 NeuralCL1BAudioProcessor::~NeuralCL1BAudioProcessor()
 {
+    modelLoader.waitUntilFinished();
 }
 
-void NeuralCL1BAudioProcessor::initializeOnnxRuntime()
-{
-    try
-    {
-        // Initialize ONNX Runtime environment
-        ortEnv = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "NeuralCL1BAudioProcessorVST");
-        
-        // Create session options
-        ortSessionOptions = std::make_unique<Ort::SessionOptions>();
-        ortSessionOptions->SetIntraOpNumThreads(1); // Important for audio plugins!
-        ortSessionOptions->SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        ortSessionOptions->SetExecutionMode(ORT_SEQUENTIAL); // Sequential execution across nodes
-        ortSessionOptions->EnableMemPattern();
-        ortSessionOptions->EnableCpuMemArena();
-        
-        DBG("ONNX Runtime initialized successfully");
-    }
-    catch (const std::exception& e)
-    {
-        DBG("Failed to initialize ONNX Runtime: " + juce::String(e.what()));
-    }
-}
 
 void NeuralCL1BAudioProcessor::initializeStates(int numChannels)
 {
-    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
-    {
-        channelStates[stateIdx].resize(numChannels);
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            channelStates[stateIdx][channel].resize(STATE_SIZE, 0.0f);
-        }
-    }
-    for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
-    {
-        channelStates_film[stateIdx].resize(numChannels);
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            channelStates_film[stateIdx][channel].resize(STATE_SIZE_FILM, 0.0f);
-        }
-    }
+    stateArena.allocate(numChannels);
     DBG("States initialized for " + juce::String(numChannels) + " channels");
 }
 //==============================================================================
@@ -144,127 +146,439 @@ void NeuralCL1BAudioProcessor::changeProgramName (int index, const juce::String&
 {
 }
 
-void NeuralCL1BAudioProcessor::loadModel(const juce::String& modelPath)
+// Runs on the loader thread
+std::unique_ptr<NeuralCL1BAudioProcessor::LoadedModel> NeuralCL1BAudioProcessor::loadModel(const juce::String& modelPath)
 {
+    auto loaded = std::make_unique<LoadedModel>();
+
+   #if NEURAL_USE_ONNXRUNTIME
     try
     {
-        // Load ONNX model
-        ortSession = std::make_unique<Ort::Session>(*ortEnv, modelPath.toStdString().c_str(), *ortSessionOptions);
+        // Shared with every other instance that has the same model open
+        loaded->session = neural::OrtSessionCache::getInstance().acquire(modelPath.toStdString(), sessionSettings);
+        auto& session = *loaded->session;
+        
+        // Models rewritten by Tools/expose_conv_history.py take the conv history as extra inputs
+        // and every scan row of the states instead of the first one
+        Ort::AllocatorWithDefaultOptions allocator;
+
+        for (size_t i = 0; i < session.GetInputCount(); ++i)
+        {
+            auto name = session.GetInputNameAllocated(i, allocator);
+
+            if (std::strcmp(name.get(), "conv_history1") == 0)
+                loaded->streamsConvHistory = true;
+
+            if (std::strcmp(name.get(), "states1") == 0)
+                loaded->carriesScanRows = session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()[1] > 1;
+        }
+        
+        loaded->numInputs = inputNameCStr.size() - (loaded->streamsConvHistory ? 0 : NUM_CONV_HISTORIES);
+        loaded->numOutputs = outputNameCStr.size() - (loaded->streamsConvHistory ? 0 : NUM_CONV_HISTORIES);
         
-        modelLoaded = true;
-        DBG("ONNX model loaded successfully: " + modelPath);
+        // Models rewritten by Tools/make_batch_dynamic.py take both channels in one call
+        loaded->takesBatch = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape()[0] < 0;
+        
+        loaded->sessionLoaded = true;
+        divergence.setTensorNames(outputNameCStr.data(), (int) loaded->numOutputs);
+        DBG("ONNX model loaded successfully: " + juce::String(neural::OrtSessionCache::getSessionModelPath(modelPath.toStdString())));
+        DBG(juce::String("Execution provider: ") + (sessionSettings.usesXnnpack() ? "XNNPACK, then CPU"
+                                                     : sessionSettings.useXnnpack ? "CPU (XNNPACK not in this build)" : "CPU"));
         
     }
     catch (const std::exception& e)
     {
         DBG("Failed to load ONNX model: " + juce::String(e.what()));
-        modelLoaded = false;
+        loaded->sessionLoaded = false;
     }
+   #endif
 
+   #if NEURAL_USE_GENERATED_MODEL
+    // Weights are compiled in, there is nothing to read
+    loaded->nativeLoaded = true;
+   #else
+    // Native model reads its weights straight from the same file
+    neural::OnnxInitializers initializers;
+    auto model = std::make_unique<NativeModel>();
+    
+    if (initializers.loadFromFile(modelPath.toStdString()) && model->load(initializers))
+    {
+        loaded->native = std::move(model);
+        loaded->nativeLoaded = true;
+        DBG("Native model loaded successfully: " + modelPath);
+    }
+    else
+    {
+        DBG("Failed to load native model weights: " + juce::String(initializers.getLastError()));
+        loaded->nativeLoaded = false;
+    }
+   #endif
+
+    return loaded;
 }
 
 //==============================================================================
 void NeuralCL1BAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-  
+    // Only sizes the buffers; the model is loaded once, by the constructor's loader thread
+    std::unique_lock<std::mutex> lock(preparationLock);
+
     // Pre-allocate ONNX input and output buffers to avoid dynamic allocations in processBlock
     
     inputBatchData[0].resize(samplesPerBlock, 0.0f);
     inputBatchData[1].resize(samplesPerBlock, 0.0f);
-    thresholdBatchData.resize(samplesPerBlock);
-    ratioBatchData.resize(samplesPerBlock);
-    attackBatchData.resize(samplesPerBlock);
-    releaseBatchData.resize(samplesPerBlock);
+    thresholdBatchData.resize(2 * samplesPerBlock);
+    ratioBatchData.resize(2 * samplesPerBlock);
+    attackBatchData.resize(2 * samplesPerBlock);
+    releaseBatchData.resize(2 * samplesPerBlock);
+    maxBlockSize = samplesPerBlock;
 
     // Initialize states for the current channel configuration
     initializeStates(getTotalNumOutputChannels());
-    
-    auto modelPath = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
-                        .getParentDirectory()
-                        .getParentDirectory()
-                        .getChildFile("Resources")
-                        .getChildFile("CL1B_nof.onnx")
-                        .getFullPathName();
-    
-    
-    DBG("Attempting to load model from: " + modelPath);
-    
-    NeuralCL1BAudioProcessor::loadModel(modelPath);
+
+   #if NEURAL_USE_ONNXRUNTIME
+    shadowBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
+    shadowStartStates.allocateLike(stateArena);
+    shadowPrimaryStates.allocateLike(stateArena);
+   #endif
     
     DBG("PrepareToPlay - numSamples: " + juce::String(samplesPerBlock));
     DBG("PrepareToPlay - numChannels: " + juce::String(getTotalNumOutputChannels()));
     
-    
-    std::vector<int64_t> inputShape = {1, static_cast<int64_t>(samplesPerBlock), 1};
-    std::vector<int64_t> condShape = {1, static_cast<int64_t>(samplesPerBlock), 1};
+   #if NEURAL_USE_ONNXRUNTIME
+    // Still loading: the loader makes the bindings before it publishes
+    const auto* model = modelLoader.get();
+
+    if (model != nullptr && model->sessionLoaded)
+    {
+        createBindings(*model, samplesPerBlock);
+
+        // A block size the session has seen reuses its measured size; a new
+        // one is measured on the loader thread, never here
+        const auto measured = model->arenaBytes.find(samplesPerBlock);
+
+        if (measured != model->arenaBytes.end())
+        {
+            realtimeArena.reserve(measured->second);
+        }
+        else if (! blockLengths.empty())
+        {
+            // The job takes the lock, so it is released before waiting for the last one
+            lock.unlock();
+            modelLoader.waitUntilFinished();
+            measuringArena = true;
 
-    // Create tensors once
+            modelLoader.start([this, model]
+            {
+                const std::lock_guard<std::mutex> jobLock(preparationLock);
+                sizeRealtimeArena(*model);
+                measuringArena = false;
+            });
+        }
+    }
+   #endif
+}
+
+#if NEURAL_USE_ONNXRUNTIME
+void NeuralCL1BAudioProcessor::createBindings(const LoadedModel& model, int samplesPerBlock)
+{
+    const int stateRows = model.carriesScanRows ? SCAN_STATE_SIZE / STATE_SIZE : 1;
+    std::vector<int64_t> stateShape = {1, stateRows, STATE_SIZE};                       // 1x1x6, or 1x4x6 when carried
+    std::vector<int64_t> newStateShape = {1, SCAN_STATE_SIZE / STATE_SIZE, STATE_SIZE}; // 1x4x6, every inner channel
+
+    blockLengths.clear();
+    blockLengths.push_back(samplesPerBlock);
+
+    // About sqrt(maxBlockSize) long and short lengths each: 47 bindings for 512 samples
+    const int granule = juce::nextPowerOfTwo((int) std::ceil(std::sqrt((double) samplesPerBlock)));
+
+    for (int length = (samplesPerBlock - 1) / granule * granule; length >= granule; length -= granule)
+        blockLengths.push_back(length);
+
+    for (int length = std::min(granule, samplesPerBlock) - 1; length > 0; --length)
+        blockLengths.push_back(length);
+
+    // Create tensors and bindings once; processWithModelBatch only picks the half and length
     try {
         for (int channel = 0; channel < getTotalNumOutputChannels(); ++channel)
         {
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, inputBatchData[channel].data(), inputBatchData[channel].size(),
-         inputShape.data(), inputShape.size()));
-        
-        DBG("inputBatchData.size(): " + juce::String((int)inputBatchData[channel].size()));
-        DBG("inputShape: [" + juce::String((int)inputShape[0]) + ", " +
-                             juce::String((int)inputShape[1]) + ", " +
-                             juce::String((int)inputShape[2]) + "]");
-        DBG("Expected tensor size: " + juce::String((int)(inputShape[0] * inputShape[1] * inputShape[2])));
-               
-        DBG("condBatchData.size(): " + juce::String((int)thresholdBatchData.size()));
-        DBG("condShape: [" + juce::String((int)condShape[0]) + ", " +
-                             juce::String((int)condShape[1]) + ", " +
-                             juce::String((int)condShape[2]) + "]");
-        
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, thresholdBatchData.data(), thresholdBatchData.size(),
-         condShape.data(), condShape.size()));
-        
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, ratioBatchData.data(), ratioBatchData.size(),
-         condShape.data(), condShape.size()));
+            outputBatchData[channel].resize(samplesPerBlock, 0.0f);
+
+            for (int half = 0; half < 2; ++half)
+            {
+                auto& bindings = channelBindings[channel][half];
+                bindings.clear();
+
+                for (int length : blockLengths)
+                {
+                    std::vector<int64_t> inputShape = {1, static_cast<int64_t>(length), 1};
+                    std::vector<int64_t> condShape = {1, static_cast<int64_t>(length), 1};
+
+                    bindings.emplace_back();
+                    auto& binding = bindings.back();
+                    auto& inputs = binding.inputs;
+                    auto& outputs = binding.outputs;
+
+                    inputs.push_back(Ort::Value::CreateTensor<float>(
+                     memoryInfo, inputBatchData[channel].data(), length,
+                     inputShape.data(), inputShape.size()));
+
+                    for (auto* control : { &thresholdBatchData, &ratioBatchData, &attackBatchData, &releaseBatchData })
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                         memoryInfo, control->data(), length,
+                         condShape.data(), condShape.size()));
+
+                    outputs.push_back(Ort::Value::CreateTensor<float>(
+                     memoryInfo, outputBatchData[channel].data(), length,
+                     inputShape.data(), inputShape.size()));
+
+                    // State tensors read this half, the new ones go to the other
+                    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(half, stateIdx, channel), stateRows * STATE_SIZE,
+                            stateShape.data(), stateShape.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, stateIdx, channel), SCAN_STATE_SIZE,
+                            newStateShape.data(), newStateShape.size()));
+                    }
+
+                    // State tensors (1 x 4 each)
+                    for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(half, FILM_SLOT + stateIdx, channel), STATE_SIZE_FILM,
+                            stateShape_film.data(), stateShape_film.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, FILM_SLOT + stateIdx, channel), STATE_SIZE_FILM,
+                            stateShape_film.data(), stateShape_film.size()));
+                    }
+
+                    // Conv history tensors (1 x 4 x 3 each), only bound for streaming models
+                    for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(half, STREAM_SLOT + historyIdx, channel), CONV_HISTORY_SIZE,
+                            convHistoryShape.data(), convHistoryShape.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, STREAM_SLOT + historyIdx, channel), CONV_HISTORY_SIZE,
+                            convHistoryShape.data(), convHistoryShape.size()));
+                    }
+
+                    binding.io = std::make_unique<Ort::IoBinding>(*model.session);
+
+                    for (size_t i = 0; i < model.numInputs; ++i)
+                        binding.io->BindInput(inputNameCStr[i], inputs[i]);
+
+                    for (size_t i = 0; i < model.numOutputs; ++i)
+                        binding.io->BindOutput(outputNameCStr[i], outputs[i]);
+                }
+            }
+
+            channelIo[channel] = { inputBatchData[channel].data(), outputBatchData[channel].data(), samplesPerBlock };
+        }
+
+        // Both channels in one tensor per input, when the model allows it
+        for (int half = 0; half < 2; ++half)
+            batchedBindings[half].clear();
+
+        if (model.takesBatch && getTotalNumOutputChannels() == 2)
+        {
+            std::vector<int64_t> batchedStateShape = {2, stateRows, STATE_SIZE};  // Mamba states are batch-first
+            std::vector<int64_t> batchedNewStateShape = {2, SCAN_STATE_SIZE / STATE_SIZE, STATE_SIZE};
+            std::vector<int64_t> batchedStateShape_film = {1, 2, STATE_SIZE_FILM}; // GRU states are [directions, batch, hidden]
+            std::vector<int64_t> batchedHistoryShape = {2, CONV_CHANNELS, NativeModel::convKernelSize - 1};
+
+            batchedInputData.resize(2 * samplesPerBlock, 0.0f);
+            batchedOutputData.resize(2 * samplesPerBlock, 0.0f);
 
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, attackBatchData.data(), attackBatchData.size(),
-         condShape.data(), condShape.size()));
-        
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, releaseBatchData.data(), releaseBatchData.size(),
-         condShape.data(), condShape.size()));
-        
-        DBG("Expected tensor size: " + juce::String((int)(condShape[0] * condShape[1] * condShape[2])));
-                 
-            // Create state tensors (1 x 6 each)
             for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
-              {
-                  inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-                      memoryInfo,
-                      channelStates[stateIdx][channel].data(),
-                      channelStates[stateIdx][channel].size(),
-                      stateShape.data(),
-                      stateShape.size()));
-              }
-    
-            // Create state tensors (1 x 4 each)
-            for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+                batchedStates[stateIdx].resize(2 * STATE_SIZE, 0.0f);
+
+            for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
             {
-                  inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-                      memoryInfo,
-                      channelStates_film[stateIdx][channel].data(),
-                      channelStates_film[stateIdx][channel].size(),
-                      stateShape_film.data(),
-                      stateShape_film.size()));
+                batchedConvHistories[historyIdx].resize(2 * CONV_HISTORY_SIZE, 0.0f);
+                batchedNewConvHistories[historyIdx].resize(2 * CONV_HISTORY_SIZE, 0.0f);
             }
-    }
+
+            for (int half = 0; half < 2; ++half)
+            {
+                for (int length : blockLengths)
+                {
+                    // The channels sit back to back at the block's length
+                    std::vector<int64_t> batchedShape = {2, static_cast<int64_t>(length), 1};
+
+                    batchedBindings[half].emplace_back();
+                    auto& binding = batchedBindings[half].back();
+                    auto& inputs = binding.inputs;
+                    auto& outputs = binding.outputs;
+
+                    inputs.push_back(Ort::Value::CreateTensor<float>(
+                        memoryInfo, batchedInputData.data(), 2 * length,
+                        batchedShape.data(), batchedShape.size()));
+
+                    for (auto* control : { &thresholdBatchData, &ratioBatchData, &attackBatchData, &releaseBatchData })
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, control->data(), 2 * length,
+                            batchedShape.data(), batchedShape.size()));
+
+                    outputs.push_back(Ort::Value::CreateTensor<float>(
+                        memoryInfo, batchedOutputData.data(), 2 * length,
+                        batchedShape.data(), batchedShape.size()));
+
+                    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                    {
+                        // A slot holds both channels back to back, which is the batched layout;
+                        // only the first rows have to be gathered
+                        if (model.carriesScanRows)
+                            inputs.push_back(Ort::Value::CreateTensor<float>(
+                                memoryInfo, stateArena.get(half, stateIdx, 0), 2 * SCAN_STATE_SIZE,
+                                batchedStateShape.data(), batchedStateShape.size()));
+                        else
+                            inputs.push_back(Ort::Value::CreateTensor<float>(
+                                memoryInfo, batchedStates[stateIdx].data(), batchedStates[stateIdx].size(),
+                                batchedStateShape.data(), batchedStateShape.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, stateIdx, 0), 2 * SCAN_STATE_SIZE,
+                            batchedNewStateShape.data(), batchedNewStateShape.size()));
+                    }
+
+                    for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(half, FILM_SLOT + stateIdx, 0), 2 * STATE_SIZE_FILM,
+                            batchedStateShape_film.data(), batchedStateShape_film.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, FILM_SLOT + stateIdx, 0), 2 * STATE_SIZE_FILM,
+                            batchedStateShape_film.data(), batchedStateShape_film.size()));
+                    }
+
+                    for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, batchedConvHistories[historyIdx].data(), batchedConvHistories[historyIdx].size(),
+                            batchedHistoryShape.data(), batchedHistoryShape.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, batchedNewConvHistories[historyIdx].data(), batchedNewConvHistories[historyIdx].size(),
+                            batchedHistoryShape.data(), batchedHistoryShape.size()));
+                    }
+
+                    binding.io = std::make_unique<Ort::IoBinding>(*model.session);
+
+                    for (size_t i = 0; i < model.numInputs; ++i)
+                        binding.io->BindInput(inputNameCStr[i], inputs[i]);
+
+                    for (size_t i = 0; i < model.numOutputs; ++i)
+                        binding.io->BindOutput(outputNameCStr[i], outputs[i]);
+                }
+            }
+
+            DBG("Stereo runs as one batch of 2");
+        }
 
      DBG("Tensors created successfully");
     }
     catch (const std::exception& e) {
      DBG("Failed to create tensors: " + juce::String(e.what()));
+     blockLengths.clear();
     }
 }
 
+// Reserves the arena the bindings for maxBlockSize need. The first time the
+// model sees a block size, every bound length runs once with the arena
+// measuring, and the size is cached with the model; ONNX Runtime also plans
+// its memory for each shape on these calls rather than on the audio thread.
+// The states they leave behind are cleared. Runs on the loader thread, under
+// preparationLock.
+void NeuralCL1BAudioProcessor::sizeRealtimeArena(const LoadedModel& model)
+{
+    const auto cached = model.arenaBytes.find(maxBlockSize);
+
+    if (cached != model.arenaBytes.end())
+    {
+        realtimeArena.reserve(cached->second);
+        return;
+    }
+
+    realtimeArena.beginMeasuring();
+    bool measured = false;
+
+    try
+    {
+        const neural::RealtimeArena::Scope allocations(realtimeArena);
+
+        for (size_t lengthIdx = 0; lengthIdx < blockLengths.size(); ++lengthIdx)
+        {
+            model.session->Run(runOptions, *channelBindings[0][0][lengthIdx].io);
+
+            if (! batchedBindings[0].empty())
+                model.session->Run(runOptions, *batchedBindings[0][lengthIdx].io);
+        }
+
+        measured = true;
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Failed to size the real-time arena: " + juce::String(e.what()));
+    }
+
+    realtimeArena.reserveMeasured();
+    stateArena.clear();
+
+    if (measured)
+        model.arenaBytes[maxBlockSize] = realtimeArena.getCapacity();
+
+    DBG("Real-time arena: " + juce::String((int) realtimeArena.getCapacity()) + " bytes");
+}
+
+// Points both halves' full-length bindings of a channel at other input /
+// output memory. Creating the views allocates, so it only happens when the
+// memory or the length changed.
+void NeuralCL1BAudioProcessor::bindChannelIo(int channel, float* input, float* output, int numSamples)
+{
+    auto& io = channelIo[channel];
+
+    if (io.input == input && io.output == output && io.numSamples == numSamples)
+        return;
+
+    std::vector<int64_t> shape = {1, static_cast<int64_t>(numSamples), 1};
+
+    for (int half = 0; half < 2; ++half)
+    {
+        auto& binding = channelBindings[channel][half][0];
+        auto& inputs = binding.inputs;
+        auto& outputs = binding.outputs;
+
+        inputs[0] = Ort::Value::CreateTensor<float>(memoryInfo, input, numSamples, shape.data(), shape.size());
+        binding.io->BindInput(inputNameCStr[0], inputs[0]);
+
+        // The controls hold at least a prepared block, so a shorter view of them fits
+        if (numSamples != io.numSamples)
+        {
+            size_t i = 1;
+
+            for (auto* control : { &thresholdBatchData, &ratioBatchData, &attackBatchData, &releaseBatchData })
+            {
+                inputs[i] = Ort::Value::CreateTensor<float>(memoryInfo, control->data(), numSamples, shape.data(), shape.size());
+                binding.io->BindInput(inputNameCStr[i], inputs[i]);
+                ++i;
+            }
+        }
+
+        outputs[0] = Ort::Value::CreateTensor<float>(memoryInfo, output, numSamples, shape.data(), shape.size());
+        binding.io->BindOutput(outputNameCStr[0], outputs[0]);
+    }
+
+    io = { input, output, numSamples };
+}
+#endif
+
 void NeuralCL1BAudioProcessor::releaseResources()
 {
     inputBatchData[0].clear();
@@ -273,6 +587,13 @@ void NeuralCL1BAudioProcessor::releaseResources()
     ratioBatchData.clear();
     attackBatchData.clear();
     releaseBatchData.clear();
+
+   #if NEURAL_USE_ONNXRUNTIME
+    if (shadowComparisonEnabled)
+        DBG("Shadow comparison: " + juce::String(divergence.getSummary()));
+
+    DBG("Shared ONNX Runtime arena: " + juce::String(neural::OrtSessionCache::getInstance().getSharedArenaUsage().toString()));
+   #endif
 }
 
 
@@ -310,21 +631,64 @@ void NeuralCL1BAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
+
+    // Audio passes through until the loader thread has published the model,
+    // and while it measures the arena for a new block size
+    const auto* model = modelLoader.get();
+
+    if (model == nullptr || measuringArena)
+        return;
+
+    // Hosts may pass more samples than they announced in prepareToPlay; the
+    // buffers and tensors hold maxBlockSize, so longer blocks go in pieces
+    if (buffer.getNumSamples() > maxBlockSize && maxBlockSize > 0)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        {
+            juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start,
+                                           std::min(maxBlockSize, buffer.getNumSamples() - start));
+            processBlock(piece, midiMessages);
+        }
+        return;
+    }
         
     // Process with ML model if loaded
-    if (modelLoaded)
+   #if NEURAL_USE_ONNXRUNTIME
+    if (shadowComparisonEnabled && model->sessionLoaded && model->nativeLoaded)
+    {
+        processWithShadowComparison(buffer);
+        return;
+    }
+   #endif
+
+    if (model->nativeLoaded && (inferenceBackend == neural::InferenceBackend::native || ! model->sessionLoaded))
+    {
+        processWithNativeModel(buffer);
+    }
+   #if NEURAL_USE_ONNXRUNTIME
+    else if (model->sessionLoaded)
     {
         processWithModelBatch(buffer);
     }
+   #endif
 }
 
+#if NEURAL_USE_ONNXRUNTIME
 void NeuralCL1BAudioProcessor::processWithModelBatch(juce::AudioBuffer<float>& buffer)
 {
     
     const int numChannels = buffer.getNumChannels();
     const int numSamples = buffer.getNumSamples();
-    std::vector<float> inputSamples;
-    inputSamples.resize(numSamples);
+
+    // Read once, so a toggle from another thread cannot change the mode mid-block
+    const bool zeroCopy = zeroCopyEnabled;
+
+    if (blockLengths.empty())
+        return;
+
+    // Whatever Run() allocates comes from the arena reserved for it
+    const neural::RealtimeArena::Scope allocations(realtimeArena);
+
     float ratio = *parameters.getRawParameterValue("ratio");
     float threshold = *parameters.getRawParameterValue("threshold");
     float attack = *parameters.getRawParameterValue("attack");
@@ -337,60 +701,282 @@ void NeuralCL1BAudioProcessor::processWithModelBatch(juce::AudioBuffer<float>& b
 
     //DBG("ratioBatchData: " + juce::String(ratioBatchData[0]));
 
+    // The batched tensors pack both channels, so zero-copy mode skips them
+    const bool batched = numChannels == 2 && ! batchedBindings[0].empty() && ! zeroCopy;
+
+    // Zero-copy mode views the whole host block at once; otherwise the block
+    // runs through the prepared lengths, longest first, so every call sees
+    // exactly the samples it is given
+    for (int start = 0; start < numSamples;)
+    {
+        const size_t lengthIdx = zeroCopy ? 0 : getBlockLengthIndex(numSamples - start);
+        const int length = zeroCopy ? numSamples : blockLengths[lengthIdx];
+
+        if (batched)
+            processWithModelBatchedChannels(buffer, start, lengthIdx);
+        else
+            processWithModelChunk(buffer, start, length, lengthIdx, zeroCopy);
+
+        start += length;
+    }
+}
+
+void NeuralCL1BAudioProcessor::processWithModelChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples, size_t lengthIdx, bool zeroCopy)
+{
+    const int half = stateArena.getCurrentHalf();
+
     // Process each channel independently
-    for (int channel = 0; channel < numChannels; ++channel)
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
     {
-        float* channelData = buffer.getWritePointer(channel);
+        float* channelData = buffer.getWritePointer(channel) + start;
         
         try
         {
-            std::copy(channelData, channelData + numSamples, inputBatchData[channel].begin());
-            
-            // Perform inference
-            auto outputTensor = ortSession->Run(
-                   Ort::RunOptions{nullptr},
-                   inputNameCStr.data(),
-                   inputTensor[channel].data(),
-                   inputNameCStr.size(), // Number of inputs
-                   outputNameCStr.data(),
-                   outputNameCStr.size() // Number of outputs
-               );
-            const float* outputData = outputTensor[0].GetTensorMutableData<float>();
-            
-            // Update states with new state values
-            for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+            if (zeroCopy)
             {
-                const float* newStateData = outputTensor[stateIdx + 1].GetTensorMutableData<float>();
-                std::copy(newStateData, newStateData + STATE_SIZE,
-                         channelStates[stateIdx][channel].begin());
-                
-                //DBG("newStateData: " + juce::String(*newStateData));
+                bindChannelIo(channel, channelData,
+                              modelOutputCanOverwriteInput ? channelData : outputBatchData[channel].data(),
+                              numSamples);
             }
-            for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+            else
             {
-                const float* newStateData = outputTensor[stateIdx + 3].GetTensorMutableData<float>();
-                std::copy(newStateData, newStateData + STATE_SIZE_FILM,
-                         channelStates_film[stateIdx][channel].begin());
-                
-                //DBG("newStateData: " + juce::String(*newStateData));
+                if (lengthIdx == 0)
+                    bindChannelIo(channel, inputBatchData[channel].data(), outputBatchData[channel].data(), blockLengths[0]);
 
-            }
-            for (int i = 0; i < numSamples; ++i)
-            {
-
-                channelData[i] = softLimit(outputData[i]);
-                //DBG("channelData: " + juce::String(channelData[i]));
+                std::copy(channelData, channelData + numSamples, inputBatchData[channel].begin());
             }
             
+            // Perform inference; the new states land in the arena's other half
+            modelLoader.get()->session->Run(runOptions, *channelBindings[channel][half][lengthIdx].io);
+
+            softLimit(zeroCopy ? channelIo[channel].output : outputBatchData[channel].data(), channelData, numSamples);
         }
         catch (const std::exception& e)
         {
             DBG("Error processing batch: " + juce::String(e.what()));
         }
     }
+
+    // Every channel has written its half, so the new states become current
+    stateArena.swap();
 }
 
+void NeuralCL1BAudioProcessor::processWithModelBatchedChannels(juce::AudioBuffer<float>& buffer, int start, size_t lengthIdx)
+{
+    const auto& model = *modelLoader.get();
+    const int numSamples = blockLengths[lengthIdx];
+    const int half = stateArena.getCurrentHalf();
+
+    try
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const float* channelData = buffer.getReadPointer(channel) + start;
+            std::copy(channelData, channelData + numSamples, batchedInputData.begin() + channel * numSamples);
+
+            if (! model.carriesScanRows)
+                for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                    std::copy(channelState(stateIdx, channel), channelState(stateIdx, channel) + STATE_SIZE,
+                              batchedStates[stateIdx].begin() + channel * STATE_SIZE);
+
+            if (model.streamsConvHistory)
+                for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+                    std::copy(channelStreamState(historyIdx, channel), channelStreamState(historyIdx, channel) + CONV_HISTORY_SIZE,
+                              batchedConvHistories[historyIdx].begin() + channel * CONV_HISTORY_SIZE);
+        }
+
+        model.session->Run(runOptions, *batchedBindings[half][lengthIdx].io);
+
+        if (model.streamsConvHistory)
+            for (int channel = 0; channel < 2; ++channel)
+                for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+                    std::copy(batchedNewConvHistories[historyIdx].begin() + channel * CONV_HISTORY_SIZE,
+                              batchedNewConvHistories[historyIdx].begin() + (channel + 1) * CONV_HISTORY_SIZE,
+                              stateArena.next(STREAM_SLOT + historyIdx, channel));
 
+        stateArena.swap();
+
+        for (int channel = 0; channel < 2; ++channel)
+            softLimit(batchedOutputData.data() + channel * numSamples, buffer.getWritePointer(channel) + start, numSamples);
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Error processing batch: " + juce::String(e.what()));
+    }
+}
+
+void NeuralCL1BAudioProcessor::processWithShadowComparison(juce::AudioBuffer<float>& buffer)
+{
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+    const bool nativeIsSelected = inferenceBackend == neural::InferenceBackend::native;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        shadowBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+    juce::AudioBuffer<float> shadow(shadowBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+    // The selected engine processes the block as usual...
+    saveStates(shadowStartStates);
+
+    if (nativeIsSelected)
+        processWithNativeModel(buffer);
+    else
+        processWithModelBatch(buffer);
+
+    // ...then the other one repeats it from the same starting point
+    saveStates(shadowPrimaryStates);
+    restoreStates(shadowStartStates);
+
+    if (nativeIsSelected)
+        processWithModelBatch(shadow);
+    else
+        processWithNativeModel(shadow);
+
+    // Tensor indices follow outputNameCStr. Only the conv history part of the
+    // stream states is shared with the session, and only when it is exposed
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        divergence.compare(0, buffer.getReadPointer(channel), shadow.getReadPointer(channel), numSamples);
+
+        for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+            divergence.compare(1 + stateIdx, shadowPrimaryStates.current(stateIdx, channel),
+                               channelState(stateIdx, channel), STATE_SIZE);
+
+        for (int stateIdx = 0; stateIdx < NUM_STATES_FILM; ++stateIdx)
+            divergence.compare(3 + stateIdx, shadowPrimaryStates.current(FILM_SLOT + stateIdx, channel),
+                               channelState_film(stateIdx, channel), STATE_SIZE_FILM);
+
+        if (modelLoader.get()->streamsConvHistory)
+            for (int historyIdx = 0; historyIdx < NUM_CONV_HISTORIES; ++historyIdx)
+                divergence.compare(4 + historyIdx, shadowPrimaryStates.current(STREAM_SLOT + historyIdx, channel),
+                                   channelStreamState(historyIdx, channel), CONV_HISTORY_SIZE);
+    }
+
+    divergence.blockCompared();
+
+    // The selected engine's states carry on
+    restoreStates(shadowPrimaryStates);
+}
+
+// Copies both halves and which one is current, so the memory the ONNX
+// bindings point at stays where it is
+void NeuralCL1BAudioProcessor::saveStates(StateSnapshot& snapshot) const
+{
+    snapshot.copyFrom(stateArena);
+}
+
+void NeuralCL1BAudioProcessor::restoreStates(const StateSnapshot& snapshot)
+{
+    stateArena.copyFrom(snapshot);
+}
+#endif
+
+
+
+void NeuralCL1BAudioProcessor::processWithNativeModel(juce::AudioBuffer<float>& buffer)
+{
+    float ratio = *parameters.getRawParameterValue("ratio");
+    float threshold = *parameters.getRawParameterValue("threshold");
+    float attack = *parameters.getRawParameterValue("attack");
+    float release = *parameters.getRawParameterValue("release");
+
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+
+    // The scan restarts its sums on every call, as the graph does on every
+    // Run(), so the block goes through in the calls processWithModelBatch makes
+   #if NEURAL_USE_ONNXRUNTIME
+    if (modelLoader.get()->sessionLoaded && ! blockLengths.empty() && ! zeroCopyEnabled)
+    {
+        for (int start = 0; start < numSamples;)
+        {
+            const int length = blockLengths[getBlockLengthIndex(numSamples - start)];
+            juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), numChannels, start, length);
+
+            nativeKernel(*this, piece.getArrayOfWritePointers(), numChannels, length, threshold, ratio, attack, release);
+            start += length;
+        }
+        return;
+    }
+   #endif
+
+    nativeKernel(*this, buffer.getArrayOfWritePointers(), numChannels, numSamples, threshold, ratio, attack, release);
+}
+
+template <typename Ops>
+void NeuralCL1BAudioProcessor::NativeKernel::run(NeuralCL1BAudioProcessor& processor, float* const* channels,
+                                                 int numChannels, int numSamples,
+                                                 float threshold, float ratio, float attack, float release)
+{
+    auto& p = processor;
+
+    std::fill(p.thresholdBatchData.begin(), p.thresholdBatchData.end(), threshold);
+    std::fill(p.ratioBatchData.begin(), p.ratioBatchData.end(), ratio);
+    std::fill(p.attackBatchData.begin(), p.attackBatchData.end(), attack);
+    std::fill(p.releaseBatchData.begin(), p.releaseBatchData.end(), release);
+
+   #if NEURAL_USE_GENERATED_MODEL
+    const auto& weights = generated::cl1b::weights; // constexpr, so the compiler can fold it in
+   #else
+    const auto& weights = p.modelLoader.get()->native->getWeights();
+   #endif
+
+    // Same states as the ONNX path, so the backend can be switched mid-stream.
+    // Offline bounces of long blocks are split across every core.
+    if (p.isNonRealtime() && neural::ScanSegments::worthSplitting(numSamples, *p.renderPool))
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* channelData = channels[channel];
+
+            NativeModel::renderParallel<Ops>(*p.renderPool, weights, channelData,
+                                             p.thresholdBatchData.data(), p.ratioBatchData.data(),
+                                             p.attackBatchData.data(), p.releaseBatchData.data(),
+                                             channelData, numSamples,
+                                             p.channelState(0, channel),
+                                             p.channelState(1, channel),
+                                             p.channelState_film(0, channel),
+                                             p.nativeStreamState(0, channel),
+                                             p.nativeStreamState(1, channel));
+        }
+    }
+    else if (numChannels == 2)
+    {
+        // Stereo goes through in one pass, left and right in adjacent SIMD lanes
+        float* states1[] = { p.channelState(0, 0), p.channelState(0, 1) };
+        float* states2[] = { p.channelState(1, 0), p.channelState(1, 1) };
+        float* hidden[] = { p.channelState_film(0, 0), p.channelState_film(0, 1) };
+        float* stream1[] = { p.nativeStreamState(0, 0), p.nativeStreamState(0, 1) };
+        float* stream2[] = { p.nativeStreamState(1, 0), p.nativeStreamState(1, 1) };
+
+        NativeModel::runInterleaved<2, Ops>(weights, channels,
+                                            p.thresholdBatchData.data(), p.ratioBatchData.data(),
+                                            p.attackBatchData.data(), p.releaseBatchData.data(),
+                                            channels, numSamples,
+                                            states1, states2, hidden, stream1, stream2);
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* channelData = channels[channel];
+
+            NativeModel::run<Ops>(weights, channelData,
+                                  p.thresholdBatchData.data(), p.ratioBatchData.data(),
+                                  p.attackBatchData.data(), p.releaseBatchData.data(),
+                                  channelData, numSamples,
+                                  p.channelState(0, channel),
+                                  p.channelState(1, channel),
+                                  p.channelState_film(0, channel),
+                                  p.nativeStreamState(0, channel),
+                                  p.nativeStreamState(1, channel));
+        }
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        neural::fastmath::softLimit<Ops>(channels[channel], channels[channel], numSamples, softLimitThreshold);
+}
 
 //==============================================================================
 bool NeuralCL1BAudioProcessor::hasEditor() const
@@ -9,7 +9,22 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <onnxruntime_cxx_api.h>
+#include <map>
+#include <mutex>
+#include "../../Common/InferenceBackend.h"
+#include "../../Common/FastMath.h"
+#include "../../Common/CpuDispatch.h"
+#include "../../Common/ParallelScan.h"
+#include "../../Common/DivergenceTracker.h"
+#include "../../Common/StateArena.h"
+#include "../../Common/BackgroundLoader.h"
+#if NEURAL_USE_ONNXRUNTIME
+ #include "../../Common/OrtSessionCache.h"
+#endif
+#include "NativeCL1BModel.h"
+#if NEURAL_USE_GENERATED_MODEL
+ #include "Generated/CL1BWeights.h"
+#endif
 
 //==============================================================================
 /**
@@ -56,34 +71,87 @@ public:
   
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
 
+    // Switches between ONNX Runtime and the built-in model; safe to call while playing
+    void setInferenceBackend (neural::InferenceBackend newBackend) { inferenceBackend = newBackend; }
+    neural::InferenceBackend getInferenceBackend() const { return inferenceBackend; }
+
+    // Instruction set the native kernels were picked for when the plugin loaded
+    neural::SimdLevel getSimdLevel() const { return simdLevel; }
+
+   #if NEURAL_USE_ONNXRUNTIME
+    // Opt-in check of one engine against the other: every block also goes
+    // through the engine that is not selected, from the same input and states,
+    // and the largest differences on the output and on each state the ONNX
+    // session returns are recorded. Doubles the processing cost.
+    void setShadowComparisonEnabled (bool shouldCompare) { shadowComparisonEnabled = shouldCompare; }
+    bool isShadowComparisonEnabled() const { return shadowComparisonEnabled; }
+    neural::DivergenceTracker& getDivergence() { return divergence; }
+
+    // Zero-copy mode: ONNX Runtime reads each channel straight from the host's
+    // buffer and writes its output back into it, instead of going through
+    // inputBatchData and outputBatchData. The tensor views are recreated (which
+    // allocates) only when the host passes another pointer or length, so the
+    // mode suits offline rendering of large buffers. Stereo then takes the
+    // per-channel calls.
+    void setZeroCopyEnabled (bool shouldBindHostBuffer) { zeroCopyEnabled = shouldBindHostBuffer; }
+    bool isZeroCopyEnabled() const { return zeroCopyEnabled; }
+
+    // Allocations inside Run() that did not fit in the arena reserved for them
+    // and went to the heap on the audio thread. ONNX Runtime's pool threads are
+    // only counted process-wide, in OrtSessionCache::getSharedArenaUsage()
+    // (see Common/RealtimeAllocator.h).
+    uint64_t getRealtimeHeapFallbacks() const { return realtimeArena.getHeapFallbacks(); }
+
+    // The arena's size, the most of it one Run() has used, and the allocations it served
+    size_t getRealtimeArenaCapacity() const { return realtimeArena.getCapacity(); }
+    size_t getRealtimeArenaHighWaterMark() const { return realtimeArena.getHighWaterMark(); }
+    uint64_t getRealtimeArenaAllocations() const { return realtimeArena.getNumAllocations(); }
+   #endif
+
 private:
     //==============================================================================
     
-    float softLimit(float input, float threshold = 0.8f)
+    // Samples beyond the threshold are replaced by their tanh, a SIMD register
+    // at a time; output may alias input
+    void softLimit(const float* input, float* output, int numSamples)
     {
-        if (std::abs(input) <= threshold)
-            return input;
-        
-        //float sign = std::copysign(1.0f, input);
-        //float excess = std::abs(input) - threshold;
-        //float limitedExcess = threshold * std::tanh(excess / threshold);
-        
-        //return sign * (threshold + limitedExcess);
-        return std::tanh(input);
+        outputLimiter(input, output, numSamples, softLimitThreshold);
     }
+
+    static constexpr float softLimitThreshold = 0.8f;
+
+    // Conditioning fill, model and output limiter of the native path, compiled
+    // once per instruction set (see CpuDispatch.h)
+    struct NativeKernel
+    {
+        template <typename Ops>
+        static void run(NeuralCL1BAudioProcessor& processor, float* const* channels, int numChannels, int numSamples,
+                        float threshold, float ratio, float attack, float release);
+    };
+
+    const neural::SimdLevel simdLevel = neural::getSimdLevel();
+    neural::SimdDispatch<NativeKernel>::Function<NeuralCL1BAudioProcessor&, float* const*, int, int,
+                                                 float, float, float, float> nativeKernel = nullptr;
+    neural::SimdDispatch<neural::SoftLimitKernel>::Function<const float*, float*, int, float> outputLimiter = nullptr;
+
+    // Worker threads for offline rendering, shared by every instance and
+    // started on the first long non-realtime block
+    std::shared_ptr<neural::TaskPool> renderPool { neural::TaskPool::getShared() };
     
     juce::AudioProcessorValueTreeState parameters;
     
+   #if NEURAL_USE_ONNXRUNTIME
     // ONNX Runtime components
-    std::unique_ptr<Ort::Env> ortEnv;
-    Ort::AllocatorWithDefaultOptions ortAllocator;
-    std::unique_ptr<Ort::SessionOptions> ortSessionOptions;
+    neural::OrtSessionSettings sessionSettings;     // instances with equal settings share a session
     Ort::MemoryInfo memoryInfo{Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU)};
-    std::unique_ptr<Ort::Session> ortSession;
+    Ort::RunOptions runOptions;
 
     // Model information
-    std::vector<const char*> inputNameCStr = {"input", "params_inputs", "params_inputs1", "params_inputs2", "params_inputs3", "states1", "states2", "hidden"};
-    std::vector<const char*> outputNameCStr = {"output", "new_states1", "new_states2", "new_hidden"};
+    // The conv history names come last and are only bound when the model was
+    // rewritten with Tools/expose_conv_history.py (see LoadedModel::numInputs / numOutputs)
+    std::vector<const char*> inputNameCStr = {"input", "params_inputs", "params_inputs1", "params_inputs2", "params_inputs3", "states1", "states2", "hidden", "conv_history1", "conv_history2"};
+    std::vector<const char*> outputNameCStr = {"output", "new_states1", "new_states2", "new_hidden", "new_conv_history1", "new_conv_history2"};
+   #endif
   
     // State management
     static const int STATE_SIZE = 6;
@@ -92,29 +160,190 @@ private:
     static const int STATE_SIZE_FILM = 4;
     static const int NUM_STATES_FILM = 1;
     
-    bool modelLoaded = false;
+    using NativeModel = NativeCL1BModel<STATE_SIZE, STATE_SIZE_FILM>;
+
+    // Everything read from the model file. The loader thread fills it in and
+    // publishes it once; it does not change after that.
+    struct LoadedModel
+    {
+       #if NEURAL_USE_ONNXRUNTIME
+        std::shared_ptr<Ort::Session> session;   // from neural::OrtSessionCache
+        bool takesBatch = false;
+        bool streamsConvHistory = false;
+        bool carriesScanRows = false;            // states1 / states2 take every scan row
+        size_t numInputs = 8;
+        size_t numOutputs = 4;
+
+        // The arena size the bindings for each block size needed, measured
+        // once on the loader thread. Only touched under preparationLock.
+        mutable std::map<int, size_t> arenaBytes;
+       #endif
+        bool sessionLoaded = false;
+
+        // Native inference path, fed with the weights from the same .onnx file
+        std::unique_ptr<NativeModel> native;
+        bool nativeLoaded = false;
+    };
+
+    // Started by the constructor; processBlock passes audio through until it
+    // has published the model
+    neural::BackgroundLoader<LoadedModel> modelLoader;
+
+    // Held while prepareToPlay resizes the buffers and while the loader
+    // creates the bindings and publishes, so the bindings always match them
+    std::mutex preparationLock;
+
+    // Set while the loader thread measures the arena for a new block size.
+    // That runs the session on the bindings and the states, so processBlock
+    // passes the audio through meanwhile.
+    std::atomic<bool> measuringArena { false };
+
+    std::atomic<neural::InferenceBackend> inferenceBackend { neural::InferenceBackend::native };
     
-    // Per-channel states (for stereo support)
-    std::vector<std::vector<float>> channelStates[NUM_STATES]; // [state_index][channel][state_data]
-    std::vector<std::vector<float>> channelStates_film[NUM_STATES_FILM]; // [state_index][channel][state_data]
+    // Per-Mamba-block streaming state: the causal conv history (shared with the
+    // ONNX session when the model exposes it) followed by the native-only scan rows
+    static const int CONV_CHANNELS = 4;
+    static const int CONV_HISTORY_SIZE = NativeModel::ScanBlock::convHistorySize;
+    static const int STREAM_STATE_SIZE = NativeModel::ScanBlock::streamStateSize;
+    static const int NUM_CONV_HISTORIES = 2;
+    
+    // Per-channel states (for stereo support), in two halves that swap roles
+    // after each ONNX Runtime call. The slots are states1, states2, hidden, then
+    // the two stream states. new_states1 / new_states2 return the scan rows of
+    // every inner channel, so those slots hold SCAN_STATE_SIZE floats per
+    // channel. The exported states1 / states2 view the first STATE_SIZE of
+    // them; models rewritten by Tools/expose_conv_history.py read all of them
+    // back (LoadedModel::carriesScanRows). The session only writes the conv
+    // history part of a stream state; the scan rows after it are native-only.
+    static const int SCAN_STATE_SIZE = NativeModel::ScanBlock::scanStateSize;
+    static const int FILM_SLOT = NUM_STATES;
+    static const int STREAM_SLOT = NUM_STATES + NUM_STATES_FILM;
+    neural::StateArena stateArena;
+
+    float* channelState(int stateIdx, int channel) const { return stateArena.current(stateIdx, channel); }
+    float* channelState_film(int stateIdx, int channel) const { return stateArena.current(FILM_SLOT + stateIdx, channel); }
+    float* channelStreamState(int historyIdx, int channel) const { return stateArena.current(STREAM_SLOT + historyIdx, channel); }
+
+    // The stream state the native path carries: only what the session's model
+    // carries too, so both engines run the same graph. The shipped model
+    // carries neither the conv history nor the scan rows.
+    float* nativeStreamState(int historyIdx, int channel) const
+    {
+       #if NEURAL_USE_ONNXRUNTIME
+        if (modelLoader.get()->streamsConvHistory)
+            return channelStreamState(historyIdx, channel);
+       #endif
+        juce::ignoreUnused(historyIdx, channel);
+        return nullptr;
+    }
     
-    std::vector<int64_t> stateShape = {1, 1, STATE_SIZE}; // 1x1x6 shape for each state
     std::vector<int64_t> stateShape_film = {1, 1, STATE_SIZE_FILM}; // 1x1x4 shape for each state
-    std::vector<Ort::Value> inputTensor[2];
+    std::vector<int64_t> convHistoryShape = {1, CONV_CHANNELS, NativeModel::convKernelSize - 1}; // 1x4x3 shape for each history
+
+    // Largest block every buffer and tensor holds; processBlock splits longer ones
+    int maxBlockSize = 0;
+
+   #if NEURAL_USE_ONNXRUNTIME
+    // Tensors and their binding for one block length: the inputs read one half
+    // of the arena and the session writes the new states, and the output
+    // samples, into preallocated memory, so Run() returns nothing
+    struct Binding
+    {
+        std::vector<Ort::Value> inputs;
+        std::vector<Ort::Value> outputs;
+        std::unique_ptr<Ort::IoBinding> io;
+    };
+
+    // Lengths there are bindings for, longest first: maxBlockSize, every
+    // multiple of a granule of about sqrt(maxBlockSize) below it, then every
+    // length below the granule. A shorter block runs as at most two calls of
+    // these exact shapes, so nothing is created on the audio thread and no
+    // call is padded (the states must end on the block's last sample).
+    std::vector<int> blockLengths;
+
+    // Index of the longest of blockLengths that fits in numSamples
+    size_t getBlockLengthIndex(int numSamples) const
+    {
+        size_t lengthIdx = 0;
+        while (blockLengths[lengthIdx] > numSamples)
+            ++lengthIdx;
+        return lengthIdx;
+    }
+
+    std::vector<Binding> channelBindings[2][2]; // [channel][half][length]
+    std::vector<float> outputBatchData[2];
+
+    // Memory each channel's full-length bindings read the input from and write
+    // the output to, so bindChannelIo only recreates the views when it changes
+    struct ChannelIo
+    {
+        float* input = nullptr;
+        float* output = nullptr;
+        int numSamples = 0;
+    };
+    ChannelIo channelIo[2];
+
+    // Zero-copy mode may bind the output to the input's memory: both nodes reading
+    // "input" (the initial dense layer and the Slice of the dry signal) feed the
+    // final Mul that writes "output", so they have run by then
+    static constexpr bool modelOutputCanOverwriteInput = true;
+    std::atomic<bool> zeroCopyEnabled { false };
+
+    // Where Run() allocates on the audio thread, sized when the bindings are made
+    neural::RealtimeArena realtimeArena;
+
+    // Stereo through one Run(), the channels packed on the batch axis, for models
+    // whose batch dimension is dynamic (see Tools/make_batch_dynamic.py). hidden
+    // and the new scan states use the arena slots as they are; the scan rows the
+    // model takes back and the conv histories are not contiguous across channels
+    // there, so they are gathered into these [channel][state_data] buffers before
+    // each call, and the new conv histories scattered back after it.
+    std::vector<Binding> batchedBindings[2]; // [half][length]
+    std::vector<float> batchedInputData;
+    std::vector<float> batchedOutputData;
+    std::vector<float> batchedStates[NUM_STATES];
+    std::vector<float> batchedConvHistories[NUM_CONV_HISTORIES];
+    std::vector<float> batchedNewConvHistories[NUM_CONV_HISTORIES];
+   #endif
 
     // Batch processing buffers
     std::vector<float> inputBatchData[2];
+    // The controls hold two blocks, so the batched tensors can cover both channels
     std::vector<float> thresholdBatchData;
     std::vector<float> ratioBatchData;
     std::vector<float> attackBatchData;
     std::vector<float> releaseBatchData;
 
+   #if NEURAL_USE_ONNXRUNTIME
+    // Shadow comparison: the block's input and the states before and after the
+    // selected engine ran, kept at full size so nothing allocates while comparing
+    using StateSnapshot = neural::StateArena;
+
+    std::atomic<bool> shadowComparisonEnabled { neural::isShadowComparisonRequested() };
+    neural::DivergenceTracker divergence;
+    juce::AudioBuffer<float> shadowBuffer;
+    StateSnapshot shadowStartStates, shadowPrimaryStates;
+   #endif
+
     // Methods
-    void initializeOnnxRuntime();
-    void getModelInputOutputInfo();
-    void loadModel(const juce::String& modelPath);
+    std::unique_ptr<LoadedModel> loadModel(const juce::String& modelPath);
+   #if NEURAL_USE_ONNXRUNTIME
     void processWithModelBatch(juce::AudioBuffer<float>& buffer);
+    void processWithModelChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples, size_t lengthIdx, bool zeroCopy);
+    void processWithModelBatchedChannels(juce::AudioBuffer<float>& buffer, int start, size_t lengthIdx);
+   #endif
+    void processWithNativeModel(juce::AudioBuffer<float>& buffer);
+   #if NEURAL_USE_ONNXRUNTIME
+    void processWithShadowComparison(juce::AudioBuffer<float>& buffer);
+    void saveStates(StateSnapshot& snapshot) const;
+    void restoreStates(const StateSnapshot& snapshot);
+   #endif
     void initializeStates(int numChannels);
+   #if NEURAL_USE_ONNXRUNTIME
+    void createBindings(const LoadedModel& model, int samplesPerBlock);
+    void bindChannelIo(int channel, float* input, float* output, int numSamples);
+    void sizeRealtimeArena(const LoadedModel& model);
+   #endif
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NeuralCL1BAudioProcessor)
 };
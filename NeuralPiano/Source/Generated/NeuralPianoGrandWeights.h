@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    NeuralPianoGrandWeights.h
+
+    Generated by Tools/GenerateModelHeader.cpp from NeuralPiano_grand.onnx.
+    Do not edit; re-run the tool after retraining the model.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../NativePianoModel.h"
+
+namespace generated::neuralPianoGrand
+{
+
+using Model = NativePianoModel<64>;
+
+// 753 values, in Model::Weights::visitArrays order
+inline constexpr Model::Weights weights
+{
+    -0.14220753f, 0.42540348f, -1.1603707f, -0.8550535f,
+
+    0.0f, 0.0f, 0.0f, 0.0f,
+
+    1.2110028f, -1.0198454f,
+
+    -0.5514456f, -0.5226302f,
+
+    -0.97805417f, -2.0015857f, -2.9894497f, -4.055488f, -4.9955983f, -5.9933314f, -7.0006065f, -7.9984894f,
+    -9.001893f, -10.039357f, -10.98979f, -11.999379f, -13.017644f, -13.997882f, -14.998871f, -15.999935f,
+    -17.002058f, -17.99807f, -18.999098f, -20.012465f, -21.001423f, -22.009071f, -22.999897f, -24.0f,
+    -25.000002f, -25.999998f, -27.000002f, -28.000002f, -28.999998f, -30.000002f, -30.997818f, -32.000137f,
+    -33.000004f, -34.003647f, -34.995296f, -36.008816f, -36.989357f, -38.001667f, -39.00418f, -39.99668f,
+    -40.988327f, -41.99633f, -42.994633f, -44.007504f, -45.00439f, -46.00532f, -47.000008f, -48.0f,
+    -49.000008f, -50.000004f, -51.0f, -51.999996f, -52.999996f, -54.000004f, -55.000004f, -55.999992f,
+    -57.0f, -57.999996f, -59.000004f, -60.000004f, -60.99999f, -61.999996f, -62.999992f, -64.0f,
+    -0.952809f, -2.0026681f, -2.9900413f, -4.0501266f, -4.994636f, -5.989823f, -7.000955f, -7.998291f,
+    -9.006223f, -10.0274725f, -10.968169f, -11.999176f, -13.003626f, -13.98872f, -15.001131f, -15.999588f,
+    -17.00276f, -17.997929f, -18.997385f, -20.002022f, -20.998499f, -22.034872f, -22.99835f, -24.0f,
+    -25.000002f, -25.999998f, -27.000002f, -28.000002f, -28.999998f, -30.000002f, -30.999607f, -32.000053f,
+    -33.000004f, -34.004475f, -34.997684f, -36.008045f, -36.993637f, -38.00665f, -38.97849f, -39.998734f,
+    -40.985535f, -41.9976f, -42.989086f, -43.992966f, -45.054462f, -46.00031f, -47.000835f, -48.00246f,
+    -49.000206f, -50.000004f, -51.0f, -51.999786f, -52.999996f, -54.000004f, -55.000004f, -55.999992f,
+    -57.0f, -57.999996f, -59.000004f, -60.000004f, -60.99999f, -61.999996f, -62.999992f, -64.0f,
+
+    1.56536f, 1.628738f,
+
+    0.19695088f, 0.27498016f, 0.13499472f, -0.18400744f, -0.15871747f, 0.13588777f, 0.024459172f, 0.19490835f,
+    -0.17749059f, -0.1094334f, -0.026841966f, -0.03387955f, 0.03533675f, 0.14792289f, -0.03656921f, 0.09674234f,
+    -0.035155714f, 0.21782134f, 0.11486465f, 0.13000506f, -0.10101101f, -0.095602214f, 0.19637285f, 0.18821093f,
+    -0.0018607804f, -0.070313394f, 0.17128712f, 0.16724657f, 0.16637142f, -0.16874439f, -0.13351998f, 0.19462642f,
+    -0.063337415f, 0.17880039f, -0.057536412f, -0.0011752001f, -0.036878914f, -0.0982571f, 0.1588973f, 0.1431518f,
+    -0.18696333f, -0.052721076f, 0.08473022f, -0.17270115f, 0.13514401f, -0.032450896f, -0.015771104f, 0.043043856f,
+    0.16981044f, -0.064664446f, 0.09571993f, -0.07520796f, -0.05203318f, 0.008976563f, 0.1625346f, 0.12028634f,
+    -0.2046283f, 0.19387178f, 0.15585561f, -0.19687042f, 0.076319814f, -0.08478314f, 0.055851586f, 0.09045353f,
+    -0.15249342f, 0.005187695f, 0.013788036f, 0.22508846f, -0.021275975f, -0.001745404f, 0.15445128f, 0.12718077f,
+    0.13530795f, 0.086383164f, 0.120843835f, 0.14265186f, -0.18764228f, -0.10392538f, 0.2061719f, -0.04052297f,
+    -0.15008797f, -0.19842747f, 0.20346671f, -0.1207496f, 0.10166697f, -0.17339878f, -0.006783759f, -0.009734895f,
+    0.15606861f, -0.010132499f, 0.10875137f, 0.2128836f, 0.023383811f, 0.06009794f, -0.13403106f, 0.16673055f,
+    0.05976374f, 0.005086794f, 0.13969243f, -0.118204705f, -0.012180433f, -0.17979129f, -0.084370784f, 0.1268823f,
+    -0.0014158952f, -0.0074818535f, -0.01721755f, -0.12261415f, -0.02607218f, -0.17959124f, -0.047509015f, 0.1667384f,
+    -0.19503345f, -0.08692769f, -0.12430961f, 0.05198746f, -0.20189685f, 0.12972547f, 0.1802997f, 0.20095795f,
+    0.10664196f, 0.11056742f, -0.013944952f, 0.15253037f, -0.18256147f, 0.1586492f, 0.11386204f, -0.07093015f,
+    0.19270241f, -0.012159217f, -0.06487382f, -0.21690632f, -0.059426717f, -0.17643844f, -0.24036148f, -0.10881929f,
+    -0.07447537f, 0.15899172f, -0.030265037f, 0.07713966f, -0.10827164f, -0.0003744428f, -0.19974634f, -0.018813852f,
+    -0.078871846f, 0.018330336f, 0.13314101f, 0.10240089f, -0.15472268f, 0.18710902f, 0.16497582f, -0.01756952f,
+    -0.062738575f, 0.03320912f, 0.03995422f, 0.10031707f, -0.18827099f, -0.16404706f, 0.18795507f, 0.12657623f,
+    0.1423517f, -0.076022625f, 0.074480794f, -0.10645765f, -0.04336604f, 0.19719738f, -0.13538598f, -0.2045718f,
+    0.055760805f, 0.19777535f, 0.16993098f, -0.09586588f, 0.19708122f, 0.07273783f, -0.16367969f, -0.17237204f,
+    -0.06607904f, -0.16028719f, 0.007135711f, -0.030583216f, 0.025963165f, -0.11934775f, 0.13072266f, 0.17826715f,
+    0.07573538f, 0.04391766f, -0.14387132f, 0.17770872f, -0.13159135f, -0.06631411f, -0.085821725f, -0.069531426f,
+    -0.10607898f, 0.14090939f, 0.16897543f, 0.057510614f, -0.025529249f, 0.052641086f, 0.21266451f, 0.00015016571f,
+    -0.16965353f, -0.07721402f, -0.12434498f, 0.17713508f, 0.0970007f, -0.075102754f, -0.17979413f, -0.03673993f,
+    0.15871993f, 0.0011409101f, -0.20875409f, -0.19684018f, 0.032834448f, 0.10073994f, 0.15934953f, 0.18977338f,
+    0.02022231f, -0.14397325f, -0.13007295f, -0.12364177f, -0.054392617f, 0.20430535f, 0.10659095f, 0.102481894f,
+    0.016898459f, 0.046470318f, -0.014262032f, 0.034129385f, -0.034082025f, -0.1493567f, 0.17342062f, 0.18449603f,
+    0.12800148f, -0.051652737f, -0.21039964f, -0.07688267f, -0.13287073f, -0.027615676f, -0.08478041f, 0.11656221f,
+    -0.00010238808f, -0.0065242373f, 0.18402903f, 0.010464919f, -0.07299123f, -0.0019057152f, -0.092131615f, -0.061324663f,
+    0.004024482f, -0.05042313f, 0.19736533f, -0.14112757f, 0.14599209f, -0.06305945f, -0.088956386f, -0.030325662f,
+    -0.17003237f, 0.13587368f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f,
+
+    0.0643566f, 1.0216528f,
+
+    -0.010745136f, -0.0314776f,
+
+    1.0431234f, 1.9578815f,
+
+    -0.03575781f,
+
+    0.37418535f, 1.2062718f, -1.152414f, 1.1201342f, 1.292428f, -0.6267264f, -0.92804736f, 0.7633741f,
+
+    0.19578786f, 0.17968275f, 0.19886222f, 0.07882857f, 0.14788197f, 0.15577437f, 0.14072874f, 0.28704393f,
+
+    -0.187517f, -0.036693417f, -0.4306743f, -0.48956463f, 0.8964176f, -0.4994754f, -0.10876521f, -0.2682989f,
+    -0.5002737f, 0.014123872f, 0.16658604f, -0.070423625f, 0.14089303f, 0.46763042f, -0.43416807f, -0.5586304f,
+    0.6155799f, 0.5744801f, -1.0832671f, -0.9588235f, 0.6265224f, 0.97561854f, -0.6501447f, -0.8798407f,
+    0.54912555f, 0.5225841f, -0.3398767f, 0.07612557f, -0.0502066f, 0.42848727f, -0.4579479f, -0.6592444f,
+
+    -0.031192029f, 0.34296024f, -0.6252508f, -0.20872432f, 0.5248913f, 0.18901119f, -0.31137294f, -0.46911076f,
+    0.016523026f, 0.08675583f, -0.031770326f, 0.047493316f, -0.1383428f, -0.05487075f, -0.020692643f, -0.15028016f,
+
+    -0.45761687f, 0.48454577f, -0.4686932f, -0.37433675f, -0.17371784f, -0.51863706f, 0.50611526f, 0.61215717f,
+    -0.09954163f, -0.80455774f, 0.48024318f, -0.014348327f, -0.78484315f, 0.40710178f, 0.13897224f, 0.34267536f,
+    -0.14295161f, 0.5292901f, 0.42333585f, 0.44440404f, -0.29062954f, -0.42538702f, 0.32803527f, 0.12959825f,
+    0.4625522f, -0.44204772f, -0.20530495f, -0.03998541f, -0.35711616f, 0.5144193f, 0.2084435f, -0.24463668f,
+    0.28154323f, 0.4120716f, 0.60825974f, -0.36141974f, -0.32271886f, 0.46463442f, 0.18543977f, -0.35810995f,
+    0.4765791f, -0.18510251f, -0.3727394f, 0.32142472f, 0.21708263f, 0.4394015f, -0.1646403f, -0.33935267f,
+    -0.08052142f, -0.5225633f, -0.92729694f, 0.2974827f, -0.07524213f, 0.08530285f, -0.23587845f, -0.523316f,
+    -0.3067566f, -0.045471694f, 0.10437567f, 0.28025183f, -0.2499574f, 0.09020149f, 0.3970455f, 0.9084409f,
+    0.105530486f, 0.4691183f, 0.5455897f, -0.1727277f, -0.6732337f, -0.31707752f, 0.35107276f, 0.053401913f,
+    0.027871361f, 0.0076141004f, -0.41966778f, 0.21254039f, -0.2967597f, 0.43928832f, -0.027581705f, -0.29718408f,
+    -0.6205128f, -0.27277222f, -0.22321756f, 0.43924043f, 0.3525103f, 0.08618682f, -0.012941019f, 0.12375463f,
+    -0.17891614f, 0.1385081f, 0.037924808f, -0.3309294f, 0.38634142f, -0.32606524f, -0.4532012f, -0.22231725f,
+    0.5546972f, 0.03711257f, 0.49819303f, 0.4983843f, -0.054903883f, -0.32604614f, -0.060667954f, 0.4523956f,
+    0.30951333f, 0.40499288f, -0.29973304f, -0.250292f, -0.06970969f, -0.2820211f, 0.40263277f, 0.22294566f,
+    0.6515563f, -0.19629358f, 0.10077847f, -0.47340307f, 0.13972981f, 0.34160158f, 0.45644727f, -0.29138824f,
+    -0.30186245f, -0.110809445f, -0.13610987f, 0.46488532f, 0.11602789f, 0.20209327f, 0.08880063f, -0.15778522f,
+
+    -0.04539472f, 0.06885186f, -0.01467391f, 0.003955154f, -0.05406908f, -0.084375046f, -0.044998668f, 0.07019345f,
+    0.11997257f, -0.054136313f, 0.06742678f, -0.0048145517f, 0.00855624f, 0.043233577f, -0.1622763f, 0.010554329f,
+
+    -0.3977611f, -0.83826405f, 0.7114263f, -0.33662587f, 0.33952752f, -0.9045825f, -0.53625727f, -0.42943552f,
+
+    0.01310876f,
+};
+
+inline void process (const float* input, const float* key, const float* velocity,
+                     float* output, int numSamples, float* h, float* stream = nullptr)
+{
+    Model::run (weights, input, key, velocity, output, numSamples, h, stream);
+}
+
+} // namespace generated::neuralPianoGrand
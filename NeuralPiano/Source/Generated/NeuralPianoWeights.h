@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    NeuralPianoWeights.h
+
+    Generated by Tools/GenerateModelHeader.cpp from NeuralPiano_up.onnx.
+    Do not edit; re-run the tool after retraining the model.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../NativePianoModel.h"
+
+namespace generated::neuralPiano
+{
+
+using Model = NativePianoModel<64>;
+
+// 753 values, in Model::Weights::visitArrays order
+inline constexpr Model::Weights weights
+{
+    0.12686339f, 0.30752012f, -1.1100645f, -0.8032289f,
+
+    0.0f, 0.0f, 0.0f, 0.0f,
+
+    1.1716456f, -0.910079f,
+
+    -0.5191064f, -0.479233f,
+
+    -0.9866802f, -2.0013995f, -2.9969249f, -3.9240983f, -5.0001564f, -6.00129f, -7.0018563f, -7.998522f,
+    -8.996008f, -9.969153f, -11.00552f, -11.9998255f, -12.964775f, -14.002685f, -15.000087f, -15.999992f,
+    -17.007086f, -18.002512f, -18.995275f, -19.954647f, -20.99433f, -21.987925f, -22.999907f, -24.0f,
+    -25.000002f, -25.999998f, -27.000002f, -28.000002f, -28.999998f, -30.000002f, -30.999569f, -32.000183f,
+    -33.00005f, -34.002213f, -34.998802f, -36.014244f, -37.011845f, -38.018097f, -38.91642f, -40.01225f,
+    -41.091587f, -41.98879f, -43.038395f, -44.004715f, -44.982517f, -46.003456f, -47.000107f, -47.998833f,
+    -49.000008f, -50.000004f, -51.0f, -52.00002f, -52.999996f, -54.000004f, -55.000004f, -55.999992f,
+    -57.0f, -57.999996f, -59.000004f, -60.000004f, -60.99999f, -61.999996f, -62.999992f, -64.0f,
+    -0.96507615f, -2.0031488f, -2.992488f, -3.8653965f, -4.9979954f, -6.0010967f, -7.002061f, -7.998398f,
+    -8.990905f, -9.942374f, -11.014532f, -11.99883f, -12.946785f, -14.00588f, -14.999629f, -15.9999275f,
+    -17.00904f, -18.001194f, -18.994528f, -19.92183f, -20.987644f, -21.9573f, -22.999594f, -24.000046f,
+    -25.00003f, -26.00001f, -27.000002f, -28.000002f, -28.999998f, -30.000002f, -30.999304f, -32.000145f,
+    -33.000004f, -34.002586f, -34.99812f, -36.016758f, -37.007072f, -38.02213f, -38.83183f, -40.016006f,
+    -41.17615f, -41.975376f, -43.081257f, -44.017315f, -44.92926f, -46.01436f, -47.002167f, -47.996063f,
+    -49.00033f, -49.999966f, -51.0f, -51.9997f, -52.999996f, -54.00003f, -55.000004f, -55.999992f,
+    -57.0f, -57.999996f, -59.000004f, -60.000004f, -60.99999f, -61.999996f, -62.999992f, -64.0f,
+
+    1.5084438f, 1.5704038f,
+
+    0.19054009f, 0.31423163f, 0.17836612f, -0.13403839f, -0.24551654f, 0.22921042f, 0.073019244f, 0.18676853f,
+    -0.16822413f, -0.12739044f, 0.018252417f, -0.007635181f, 0.008623489f, 0.11761231f, -0.02620437f, 0.10980852f,
+    -0.043632332f, 0.19370772f, 0.109496064f, 0.12631078f, -0.0884639f, -0.09095773f, 0.20772181f, 0.18943772f,
+    -0.005549037f, -0.07791833f, 0.16779065f, 0.17036325f, 0.17797042f, -0.1612583f, -0.13161275f, 0.20083594f,
+    -0.05925419f, 0.1785817f, -0.05206996f, -0.0064284317f, -0.045084037f, -0.09412805f, 0.16650946f, 0.15256222f,
+    -0.1895028f, -0.06124943f, 0.08156014f, -0.1787808f, 0.13403729f, -0.037057627f, -0.013114068f, 0.044956814f,
+    0.16746409f, -0.060709465f, 0.09462939f, -0.076635346f, -0.05438545f, 0.008011364f, 0.16307221f, 0.122695364f,
+    -0.20485327f, 0.20008841f, 0.15209554f, -0.19163911f, 0.07271172f, -0.08543234f, 0.056327786f, 0.085316f,
+    -0.14702092f, 0.023170622f, -0.039643016f, 0.103799805f, -0.20808132f, -0.016190048f, 0.13856895f, 0.15678602f,
+    0.14204876f, 0.059834316f, 0.1391335f, 0.12598479f, -0.18774727f, -0.12051032f, 0.20271507f, -0.0416394f,
+    -0.15134682f, -0.17877942f, 0.21838088f, -0.1284716f, 0.112932324f, -0.16552243f, -0.0011725853f, -0.007654091f,
+    0.1580695f, -0.010136892f, 0.11863404f, 0.20721799f, 0.019235406f, 0.06639507f, -0.13072386f, 0.17938635f,
+    0.05394895f, 0.013846044f, 0.13258208f, -0.12102341f, -0.002709367f, -0.18941104f, -0.09109044f, 0.1334766f,
+    0.0035530222f, -0.0016121119f, -0.019455932f, -0.11874193f, -0.022138327f, -0.18470174f, -0.05236765f, 0.16546135f,
+    -0.19756146f, -0.08745128f, -0.12409893f, 0.051836845f, -0.20567846f, 0.13330297f, 0.18656886f, 0.20433728f,
+    0.10553344f, 0.1090331f, -0.007855203f, 0.14720649f, -0.18361284f, 0.15550624f, 0.11263103f, -0.07287163f,
+    0.19492221f, -0.018096615f, -0.014696704f, -0.17715031f, -0.019591734f, -0.27453095f, -0.140467f, -0.055383943f,
+    -0.08178895f, 0.17078291f, -0.0527443f, 0.13359821f, -0.074310355f, -0.03639372f, -0.24056971f, -0.0027295079f,
+    -0.061485898f, 0.00451163f, 0.09818353f, 0.098492004f, -0.16189545f, 0.20651215f, 0.16954619f, -0.0007818858f,
+    -0.060871936f, 0.030033108f, 0.028500536f, 0.09723363f, -0.18108702f, -0.14667332f, 0.20007564f, 0.1276162f,
+    0.15416798f, -0.06939882f, 0.07475257f, -0.09681117f, -0.052843403f, 0.18524416f, -0.13214158f, -0.19468814f,
+    0.0714837f, 0.19409901f, 0.15725885f, -0.100921884f, 0.1867447f, 0.07091231f, -0.17252135f, -0.16883765f,
+    -0.06163956f, -0.16569239f, 0.012482433f, -0.033393297f, 0.02420283f, -0.124870785f, 0.13050283f, 0.1808903f,
+    0.081336215f, 0.044487815f, -0.13322216f, 0.17188051f, -0.12225811f, -0.07354033f, -0.085500404f, -0.0677725f,
+    -0.11477621f, 0.15110983f, 0.20623332f, 0.004876949f, -0.15101494f, -0.14349672f, 0.20144196f, -0.014168813f,
+    -0.13579707f, -0.06944612f, -0.15784764f, 0.20167032f, 0.07689632f, -0.0766657f, -0.2010845f, -0.041179936f,
+    0.15929039f, -0.0017443331f, -0.17984363f, -0.17480728f, 0.023810802f, 0.11578152f, 0.1693646f, 0.20085809f,
+    0.025810523f, -0.14113931f, -0.13146603f, -0.10699473f, -0.060177457f, 0.201007f, 0.113852546f, 0.10552832f,
+    0.038116377f, 0.037159886f, 0.0009187507f, 0.023068039f, -0.03860214f, -0.1361881f, 0.15802543f, 0.17707276f,
+    0.13987832f, -0.04666673f, -0.20252937f, -0.079439454f, -0.12896778f, -0.02034668f, -0.093154415f, 0.10891643f,
+    -0.0015875422f, -0.008974798f, 0.18270604f, 0.011628502f, -0.07395855f, -0.0083823465f, -0.08644904f, -0.05013571f,
+    0.01045592f, -0.053941727f, 0.19689359f, -0.13038644f, 0.13615386f, -0.0640993f, -0.09463238f, -0.031683095f,
+    -0.17238f, 0.1381149f,
+
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f,
+
+    0.06357271f, 1.0203115f,
+
+    -0.005278066f, -0.014643674f,
+
+    0.98182845f, 1.9028692f,
+
+    -0.04238261f,
+
+    -0.23023647f, 1.1694431f, -1.118674f, 1.014311f, 1.2260754f, -0.7199373f, -0.9365044f, 0.61289006f,
+
+    -0.08709827f, 0.17635937f, 0.20478112f, 0.089937724f, 0.16301101f, 0.18861847f, 0.18004929f, 0.2690921f,
+
+    -0.17075863f, -0.100250736f, -0.32257754f, -0.46506572f, 0.79525f, -0.52910686f, -0.2158005f, -0.22032924f,
+    -0.3582235f, 0.0287738f, 0.15050767f, -0.059910968f, 0.14296494f, 0.5207749f, -0.5367982f, -0.5563296f,
+    0.18076508f, 0.44552523f, -0.9882683f, -0.7605675f, 0.48340568f, 0.9429909f, -0.5236462f, -0.76375765f,
+    0.49332425f, 0.52882946f, -0.31805706f, 0.04569763f, -0.020099146f, 0.4253943f, -0.44735613f, -0.6588335f,
+
+    -0.3220866f, 0.3982052f, -0.70085865f, -0.35537553f, 0.5835307f, 0.33136293f, -0.4383244f, -0.45933586f,
+    0.14971727f, 0.08457931f, -0.06467226f, 0.0840857f, -0.15391319f, 0.012670272f, -0.10747215f, -0.16090964f,
+
+    -0.37991017f, 0.50062674f, -0.40027002f, -0.35532555f, -0.15688758f, -0.5062683f, 0.54076767f, 0.36820433f,
+    -0.038504206f, -0.6561592f, 0.42331856f, -0.03920663f, -0.6288866f, 0.3763007f, 0.13055716f, 0.3981993f,
+    -0.07335771f, 0.5549951f, 0.45358637f, 0.47204065f, -0.28692123f, -0.3550273f, 0.37470832f, -0.08378882f,
+    0.45148554f, -0.47850728f, -0.23335807f, -0.08185945f, -0.31675124f, 0.4807923f, 0.22267646f, -0.21256173f,
+    0.2332251f, 0.37438217f, 0.5891847f, -0.3833277f, -0.28054327f, 0.45411158f, 0.17667122f, -0.5332052f,
+    0.51244795f, -0.1366238f, -0.40335798f, 0.30245796f, 0.17699736f, 0.46408057f, -0.16052662f, -0.21769741f,
+    -0.39437652f, -0.4379748f, -0.8452447f, 0.33431396f, -0.23329015f, -0.22372213f, -0.23898669f, 0.031833507f,
+    -0.3237386f, -0.11920058f, 0.16958053f, 0.37620053f, -0.36502603f, 0.09900466f, 0.2403568f, 0.7061246f,
+    0.45354792f, 0.45113447f, 0.545536f, -0.13203661f, -0.5349616f, 0.19748467f, 0.47559357f, -0.2525272f,
+    0.11056615f, -0.039676256f, -0.5414828f, 0.022341639f, -0.1886825f, 0.4629633f, 0.18835986f, -0.13722493f,
+    -0.5579414f, -0.2319226f, -0.22100973f, 0.4811742f, 0.34481302f, 0.13601156f, 0.03211334f, 0.12703419f,
+    -0.20500734f, -0.015769666f, 0.06432401f, -0.37087372f, 0.3714464f, -0.36861125f, -0.44404897f, -0.25302774f,
+    0.52227473f, -0.00978065f, 0.49592397f, 0.46007597f, -0.024544017f, -0.3414459f, -0.0902344f, 0.42073202f,
+    0.34431294f, 0.58115965f, -0.33597922f, -0.22638933f, -0.015991356f, -0.24510951f, 0.41945451f, 0.29054576f,
+    0.61936224f, -0.23812649f, 0.08790939f, -0.5171385f, 0.15434916f, 0.3027341f, 0.40764394f, -0.18237276f,
+    -0.27794543f, 0.027128896f, -0.13973181f, 0.5173796f, 0.16278253f, 0.22271241f, 0.09654534f, -0.16162619f,
+
+    -0.24329653f, 0.10874161f, -0.027929308f, 0.040681526f, -0.0697668f, -0.15761717f, 0.0040305117f, 0.06797133f,
+    0.06032995f, -0.21096948f, 0.09766109f, -0.0066064983f, -0.18659197f, 0.016232545f, -0.21482901f, 0.05854241f,
+
+    -0.3691197f, -0.821949f, 0.6952193f, -0.36596945f, 0.24085788f, -0.90253454f, -0.53774464f, -0.33049995f,
+
+    0.057526056f,
+};
+
+inline void process (const float* input, const float* key, const float* velocity,
+                     float* output, int numSamples, float* h, float* stream = nullptr)
+{
+    Model::run (weights, input, key, velocity, output, numSamples, h, stream);
+}
+
+} // namespace generated::neuralPiano
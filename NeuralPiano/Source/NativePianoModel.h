@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    NativePianoModel.h
+
+    Built-in implementation of NeuralPiano_up.onnx / NeuralPiano_grand.onnx:
+    a 64-state selective-scan block followed by a GELU dense layer, FiLM on
+    (key, velocity), a softsign GLU and a linear output layer. Both files
+    share the same topology and initializer names.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../../Common/NeuralLayers.h"
+#include "../../Common/ParallelScan.h"
+
+//==============================================================================
+template <int StateSize, int InnerSize = 2, int HiddenSize = 8>
+class NativePianoModel
+{
+public:
+    static constexpr int convKernelSize = 1;
+    static constexpr int numConditioning = 2;
+
+    using ScanBlock = neural::SelectiveScanBlock<1, InnerSize, StateSize, convKernelSize>;
+
+    struct Weights
+    {
+        ScanBlock s6;
+        neural::Dense<1, HiddenSize> dense;
+        neural::Dense<numConditioning, 2 * HiddenSize> film;
+        neural::SoftsignGlu<HiddenSize> glu;
+        neural::Dense<HiddenSize, 1> outputLayer;
+
+        template <typename Visitor>
+        void visitArrays (Visitor&& visit) const
+        {
+            s6.visitArrays (visit);
+            dense.visitArrays (visit);
+            film.visitArrays (visit);
+            glu.visitArrays (visit);
+            outputLayer.visitArrays (visit);
+        }
+    };
+
+    bool load (const std::string& modelPath)
+    {
+        neural::OnnxInitializers initializers;
+
+        return initializers.loadFromFile (modelPath) && load (initializers);
+    }
+
+    bool load (const neural::OnnxInitializers& w)
+    {
+        return weights.s6.load (w, { "onnx::MatMul_176", "s6.conv1d.weight", "s6.conv1d.bias",
+                                     "onnx::Exp_185", "onnx::Mul_186", "onnx::MatMul_187",
+                                     "onnx::MatMul_188", "s6.delta_t_projection.bias",
+                                     "onnx::MatMul_198", "s6.out_projection.bias" })
+            && weights.dense.load (w, "onnx::MatMul_199", "dense.bias")
+            && weights.film.load (w, "onnx::MatMul_200", "film.bias")
+            && weights.glu.load (w, "onnx::MatMul_201", "glu.bias")
+            && weights.outputLayer.load (w, "onnx::MatMul_202", "output_layer.bias");
+    }
+
+    const Weights& getWeights() const   { return weights; }
+
+    // Runs one block for one channel, as one Run() of the graph (see
+    // SelectiveScanBlock). h is the [StateSize] vector exchanged with the
+    // ONNX session as h / new_h, updated in place. output may alias input.
+    // stream ([ScanBlock::streamStateSize]) carries the second inner channel's
+    // scan row across blocks, as models rewritten by Tools/expose_conv_history.py
+    // do; without it that row restarts from h, as in the exported graph.
+    void process (const float* input, const float* key, const float* velocity,
+                  float* output, int numSamples, float* h, float* stream = nullptr) const
+    {
+        run (weights, input, key, velocity, output, numSamples, h, stream);
+    }
+
+    // The same, for weights that do not live in a model object, e.g. the
+    // constexpr ones in a header written by Tools/GenerateModelHeader.cpp.
+    // Ops picks the instruction set (see CpuDispatch.h).
+    template <typename Ops = neural::fastmath::NativeOps>
+    static void run (const Weights& w, const float* input, const float* key, const float* velocity,
+                     float* output, int numSamples, float* h, float* stream = nullptr)
+    {
+        typename ScanBlock::State scan;
+        ScanBlock::loadCarriedState (scan, h, stream);
+
+        for (int i = 0; i < numSamples; ++i)
+            processSample<Ops> (w, scan, input[i], key[i], velocity[i], output[i]);
+
+        ScanBlock::storeCarriedState (scan, h, stream);
+    }
+
+    // The same result as run() (to float rounding), computed on all of the
+    // pool's threads; for offline rendering of long blocks (see ParallelScan.h).
+    // Call it from a CpuDispatch entry for Ops.
+    template <typename Ops = neural::fastmath::NativeOps>
+    static void renderParallel (neural::TaskPool& pool, const Weights& w,
+                                const float* input, const float* key, const float* velocity,
+                                float* output, int numSamples, float* h, float* stream = nullptr)
+    {
+        typename ScanBlock::State scan;
+        ScanBlock::loadCarriedState (scan, h, stream);
+
+        const neural::ScanSegments segments (numSamples, pool);
+        std::vector<typename ScanBlock::State> starts;
+        neural::findSegmentStarts<Ops> (pool, w.s6, input, segments, scan, starts);
+
+        neural::parallelFor<Ops> (pool, segments.numSegments, [&] (int s)
+        {
+            auto& state = starts[(size_t) s];
+
+            for (int i = segments.begin (s); i < segments.end (s); ++i)
+                processSample<Ops> (w, state, input[i], key[i], velocity[i], output[i]);
+        });
+
+        ScanBlock::storeCarriedState (starts.back(), h, stream);
+    }
+
+private:
+    Weights weights;
+
+    template <typename Ops>
+    static void processSample (const Weights& w, typename ScanBlock::State& scan,
+                               float input, float key, float velocity, float& output)
+    {
+        float scanned;
+        w.s6.template step<Ops> (&input, &scanned, scan);
+
+        float hidden[HiddenSize];
+        w.dense.forward (&scanned, hidden);
+
+        const float cond[numConditioning] = { key, velocity };
+        float filmOut[2 * HiddenSize];
+        w.film.forward (cond, filmOut);
+
+        neural::gelu<HiddenSize, Ops> (hidden);
+
+        for (int k = 0; k < HiddenSize; ++k)
+            hidden[k] = filmOut[k] * hidden[k] + filmOut[HiddenSize + k];
+
+        float gated[HiddenSize];
+        w.glu.forward (hidden, gated);
+        w.outputLayer.forward (gated, &output);
+    }
+};
@@ -48,23 +48,66 @@ NeuralPianoAudioProcessorEditor::NeuralPianoAudioProcessorEditor (NeuralPianoAud
     addAndMakeVisible(keyLabel);
     
     
+    // Set up Body slider, 0 = upright, 1 = grand
+    bodySlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    bodySlider.setColour(juce::Slider::textBoxTextColourId, juce::Colours::deepskyblue);
+    bodySlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+    bodySlider.setTooltip("Morphs the piano from the upright (0) to the grand (1) recording. "
+                          "Native engine only: ONNX Runtime plays the upright model whatever the setting.");
+    addAndMakeVisible(bodySlider);
+    
+    bodyLabel.setText("Body", juce::dontSendNotification);
+    bodyLabel.setColour(juce::Label::textColourId, juce::Colours::deepskyblue);
+    bodyLabel.attachToComponent(&bodySlider, true);
+    addAndMakeVisible(bodyLabel);
+    
+    
+    // Set up inference engine toggle, naming the instruction set the native kernels run on
+    nativeButton.setButtonText("Native engine (" + juce::String(neural::getSimdLevelName(audioProcessor.getSimdLevel())) + ")");
+    nativeButton.setToggleState(audioProcessor.getInferenceBackend() == neural::InferenceBackend::native,
+                                juce::dontSendNotification);
+    nativeButton.setColour(juce::ToggleButton::textColourId, juce::Colours::deepskyblue);
+    nativeButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::deepskyblue);
+    nativeButton.addListener(this);
+    addAndMakeVisible(nativeButton);
+   #if ! NEURAL_USE_ONNXRUNTIME
+    nativeButton.setEnabled(false); // native-only build, nothing to switch to
+   #endif
+    updateBodySlider();
+    
     // Create the attachment - this connects the slider to the parameter
     velAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getParameters(), "v", velSlider);
     keyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getParameters(), "k", keySlider);
+    bodyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getParameters(), "body", bodySlider);
     
-    setSize (400, 200);
+    setSize (400, 280);
     
 }
 
 NeuralPianoAudioProcessorEditor::~NeuralPianoAudioProcessorEditor()
 {
+    nativeButton.removeListener(this);
 }
 
 void NeuralPianoAudioProcessorEditor::buttonClicked (juce::Button* button)
 {
+    if (button == &nativeButton)
+    {
+        audioProcessor.setInferenceBackend(nativeButton.getToggleState() ? neural::InferenceBackend::native
+                                                                         : neural::InferenceBackend::onnxRuntime);
+        updateBodySlider();
+    }
+}
+
+void NeuralPianoAudioProcessorEditor::updateBodySlider()
+{
+    const bool applies = audioProcessor.isNativeEngineActive();
 
+    bodySlider.setEnabled(applies);
+    bodyLabel.setEnabled(applies);
 }
 
 
@@ -87,6 +130,7 @@ void NeuralPianoAudioProcessorEditor::resized()
 {
     
     auto area = getLocalBounds();
+    nativeButton.setBounds(area.removeFromBottom(30).removeFromRight(200));
     area.removeFromTop(30); // Title space
     area.reduce(20, 10);    // Margins
     
@@ -97,8 +141,13 @@ void NeuralPianoAudioProcessorEditor::resized()
     //area.removeFromTop(10); // Spacing between sliders
     
     // Gain slider
-    auto gainArea = area.removeFromTop(120);
+    auto gainArea = area.removeFromTop(60);
     gainArea.removeFromLeft(120); // Label space
     velSlider.setBounds(gainArea);
+    
+    // Body slider
+    auto bodyArea = area.removeFromTop(60);
+    bodyArea.removeFromLeft(120); // Label space
+    bodySlider.setBounds(bodyArea);
 
 }
@@ -39,6 +39,17 @@ private:
     juce::Slider velSlider;
     juce::Label velLabel;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> velAttachment;
+
+    // Upright to grand morph of the native model; disabled while ONNX Runtime,
+    // which only has the upright model, is running
+    juce::Slider bodySlider;
+    juce::Label bodyLabel;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bodyAttachment;
+    
+    juce::ToggleButton nativeButton { "Native engine" };
+    juce::TooltipWindow tooltipWindow { this };
+
+    void updateBodySlider();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NeuralPianoAudioProcessorEditor)
 };
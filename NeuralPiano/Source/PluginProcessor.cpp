@@ -24,51 +24,59 @@ NeuralPianoAudioProcessor::NeuralPianoAudioProcessor()
                                          std::make_unique<juce::AudioParameterFloat>(
                                              "v", "Velocity", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f),
                            std::make_unique<juce::AudioParameterFloat>(
-                               "k", "KeyNumber", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f)
+                               "k", "KeyNumber", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f),
+                           std::make_unique<juce::AudioParameterFloat>(
+                               "body", "Body", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f)
                                      })
 #endif
 {
-    initializeOnnxRuntime();
+    nativeKernel = neural::SimdDispatch<NativeKernel>::select<NeuralPianoAudioProcessor&, float* const*, int, int,
+                                                              float, float, float>(simdLevel);
+    outputLimiter = neural::SimdDispatch<neural::SoftLimitKernel>::select<const float*, float*, int, float>(simdLevel);
+    DBG("Native kernels: " + juce::String(neural::getSimdLevelName(simdLevel)));
+
+    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+        stateArena.addSlot(SCAN_STATE_SIZE);
+
+    auto modelPath = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
+                        .getParentDirectory()
+                        .getParentDirectory()
+                        .getChildFile("Resources")
+                        .getChildFile("NeuralPiano_up.onnx")
+                        .getFullPathName();
+
+    DBG("Attempting to load model from: " + modelPath);
+
+    // The session is created once, here, off the message and audio threads
+    modelLoader.start([this, modelPath]
+    {
+        auto model = loadModel(modelPath);
+
+        const std::lock_guard<std::mutex> lock(preparationLock);
+
+       #if NEURAL_USE_ONNXRUNTIME
+        // Prepared before the model was ready: the bindings are made here
+        if (model->sessionLoaded && maxBlockSize > 0)
+        {
+            createBindings(*model, maxBlockSize);
+            sizeRealtimeArena(*model);
+        }
+       #endif
+
+        modelLoader.publish(std::move(model));
+    });
 }
 
 NeuralPianoAudioProcessor::~NeuralPianoAudioProcessor()
 {
+    modelLoader.waitUntilFinished();
 }
 
-void NeuralPianoAudioProcessor::initializeOnnxRuntime()
-{
-    try
-    {
-        // Initialize ONNX Runtime environment
-        ortEnv = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "NeuralPianoAudioVST");
-        
-        // Create session options
-        ortSessionOptions = std::make_unique<Ort::SessionOptions>();
-        ortSessionOptions->SetIntraOpNumThreads(1); // Important for audio plugins!
-        ortSessionOptions->SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        ortSessionOptions->SetExecutionMode(ORT_SEQUENTIAL); // Sequential execution across nodes
-        ortSessionOptions->EnableMemPattern();
-        ortSessionOptions->EnableCpuMemArena();
-        
-        DBG("ONNX Runtime initialized successfully");
-    }
-    catch (const std::exception& e)
-    {
-        DBG("Failed to initialize ONNX Runtime: " + juce::String(e.what()));
-    }
-}
 
 
 void NeuralPianoAudioProcessor::initializeStates(int numChannels)
 {
-    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
-    {
-        channelStates[stateIdx].resize(numChannels);
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            channelStates[stateIdx][channel].resize(STATE_SIZE, 0.0f);
-        }
-    }
+    stateArena.allocate(numChannels);
     DBG("States initialized for " + juce::String(numChannels) + " channels");
 }
 //==============================================================================
@@ -133,113 +141,386 @@ void NeuralPianoAudioProcessor::changeProgramName (int index, const juce::String
 {
 }
 
-void NeuralPianoAudioProcessor::loadModel(const juce::String& modelPath)
+// Runs on the loader thread
+std::unique_ptr<NeuralPianoAudioProcessor::LoadedModel> NeuralPianoAudioProcessor::loadModel(const juce::String& modelPath)
 {
+    auto loaded = std::make_unique<LoadedModel>();
+
+   #if NEURAL_USE_ONNXRUNTIME
     try
     {
-        // Load ONNX model
-        ortSession = std::make_unique<Ort::Session>(*ortEnv, modelPath.toStdString().c_str(), *ortSessionOptions);
+        // Shared with every other instance that has the same model open
+        loaded->session = neural::OrtSessionCache::getInstance().acquire(modelPath.toStdString(), sessionSettings);
     
+        // Models rewritten by Tools/make_batch_dynamic.py take both channels in one call
+        loaded->takesBatch = loaded->session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape()[0] < 0;
+
+        // Models rewritten by Tools/expose_conv_history.py take every scan row of h
+        Ort::AllocatorWithDefaultOptions allocator;
+
+        for (size_t i = 0; i < loaded->session->GetInputCount(); ++i)
+            if (std::strcmp(loaded->session->GetInputNameAllocated(i, allocator).get(), "h") == 0)
+                loaded->carriesScanRows = loaded->session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()[1] > 1;
         
-        modelLoaded = true;
-        DBG("ONNX model loaded successfully: " + modelPath);
+        loaded->sessionLoaded = true;
+        divergence.setTensorNames(outputNameCStr.data(), (int) outputNameCStr.size());
+        DBG("ONNX model loaded successfully: " + juce::String(neural::OrtSessionCache::getSessionModelPath(modelPath.toStdString())));
+        DBG(juce::String("Execution provider: ") + (sessionSettings.usesXnnpack() ? "XNNPACK, then CPU"
+                                                     : sessionSettings.useXnnpack ? "CPU (XNNPACK not in this build)" : "CPU"));
         
     }
     catch (const std::exception& e)
     {
         DBG("Failed to load ONNX model: " + juce::String(e.what()));
-        modelLoaded = false;
+        loaded->sessionLoaded = false;
     }
+   #endif
     
-  
+   #if NEURAL_USE_GENERATED_MODEL
+    // Weights are compiled in, there is nothing to read
+    loaded->nativeLoaded = true;
+    loaded->bodyMorph.build(generated::neuralPiano::weights, generated::neuralPianoGrand::weights);
+   #else
+    // Native model reads its weights straight from the same file
+    neural::OnnxInitializers initializers;
+    auto model = std::make_unique<NativeModel>();
+
+    if (initializers.loadFromFile(modelPath.toStdString()) && model->load(initializers))
+    {
+        loaded->native = std::move(model);
+        loaded->nativeLoaded = true;
+        DBG("Native model loaded successfully: " + modelPath);
+    }
+    else
+    {
+        DBG("Failed to load native model weights: " + juce::String(initializers.getLastError()));
+        loaded->nativeLoaded = false;
+    }
 
+    // The grand model next to it is the other end of the body morph
+    auto grandPath = juce::File(modelPath).getSiblingFile("NeuralPiano_grand.onnx").getFullPathName();
+    NativeModel grandModel;
+
+    if (loaded->nativeLoaded && grandModel.load(grandPath.toStdString()))
+    {
+        loaded->bodyMorph.build(loaded->native->getWeights(), grandModel.getWeights());
+        DBG("Body morph ready: " + grandPath);
+    }
+    else
+    {
+        DBG("No grand model for the body morph: " + grandPath);
+    }
+   #endif
+
+    return loaded;
 }
 
 
 //==============================================================================
 void NeuralPianoAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-  
+    // Only sizes the buffers; the model is loaded once, by the constructor's loader thread
+    std::unique_lock<std::mutex> lock(preparationLock);
+
     // Pre-allocate ONNX input and output buffers to avoid dynamic allocations in processBlock
     
     inputBatchData[0].resize(samplesPerBlock);
     inputBatchData[1].resize(samplesPerBlock);
 
-    kBatchData.resize(samplesPerBlock);
-    vBatchData.resize(samplesPerBlock);
+    kBatchData.resize(2 * samplesPerBlock);
+    vBatchData.resize(2 * samplesPerBlock);
+    maxBlockSize = samplesPerBlock;
 
     // Initialize states for the current channel configuration
     initializeStates(getTotalNumOutputChannels());
-    
-    auto modelPath = juce::File::getSpecialLocation(juce::File::currentExecutableFile)
-                        .getParentDirectory()
-                        .getParentDirectory()
-                        .getChildFile("Resources")
-                        .getChildFile("NeuralPiano_up.onnx")
-                        .getFullPathName();
-    
-    
-    DBG("Attempting to load model from: " + modelPath);
-    
-    NeuralPianoAudioProcessor::loadModel(modelPath);
+
+   #if NEURAL_USE_ONNXRUNTIME
+    shadowBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
+    shadowStartStates.allocateLike(stateArena);
+    shadowPrimaryStates.allocateLike(stateArena);
+    saveStates(shadowStartStates);
+    saveStates(shadowPrimaryStates);
+   #endif
     
     DBG("PrepareToPlay - numSamples: " + juce::String(samplesPerBlock));
     DBG("PrepareToPlay - numChannels: " + juce::String(getTotalNumOutputChannels()));
     
-    
-    std::vector<int64_t> inputShape = {1, static_cast<int64_t>(samplesPerBlock), 1};
-    std::vector<int64_t> condShape = {1, static_cast<int64_t>(samplesPerBlock), 1};
+   #if NEURAL_USE_ONNXRUNTIME
+    // Still loading: the loader makes the bindings before it publishes
+    const auto* model = modelLoader.get();
+
+    if (model != nullptr && model->sessionLoaded)
+    {
+        createBindings(*model, samplesPerBlock);
+
+        // A block size the session has seen reuses its measured size; a new
+        // one is measured on the loader thread, never here
+        const auto measured = model->arenaBytes.find(samplesPerBlock);
+
+        if (measured != model->arenaBytes.end())
+        {
+            realtimeArena.reserve(measured->second);
+        }
+        else if (! blockLengths.empty())
+        {
+            // The job takes the lock, so it is released before waiting for the last one
+            lock.unlock();
+            modelLoader.waitUntilFinished();
+            measuringArena = true;
+
+            modelLoader.start([this, model]
+            {
+                const std::lock_guard<std::mutex> jobLock(preparationLock);
+                sizeRealtimeArena(*model);
+                measuringArena = false;
+            });
+        }
+    }
+   #endif
+}
 
-    // Create tensors once
+#if NEURAL_USE_ONNXRUNTIME
+void NeuralPianoAudioProcessor::createBindings(const LoadedModel& model, int samplesPerBlock)
+{
+    const int stateRows = model.carriesScanRows ? SCAN_STATE_SIZE / STATE_SIZE : 1;
+    std::vector<int64_t> stateShape = {1, stateRows, STATE_SIZE};                       // 1x1x64, or 1x2x64 when carried
+    std::vector<int64_t> newStateShape = {1, SCAN_STATE_SIZE / STATE_SIZE, STATE_SIZE}; // 1x2x64, every inner channel
+
+    blockLengths.clear();
+    blockLengths.push_back(samplesPerBlock);
+
+    // About sqrt(maxBlockSize) long and short lengths each: 47 bindings for 512 samples
+    const int granule = juce::nextPowerOfTwo((int) std::ceil(std::sqrt((double) samplesPerBlock)));
+
+    for (int length = (samplesPerBlock - 1) / granule * granule; length >= granule; length -= granule)
+        blockLengths.push_back(length);
+
+    for (int length = std::min(granule, samplesPerBlock) - 1; length > 0; --length)
+        blockLengths.push_back(length);
+
+    // Create tensors and bindings once; processWithModelBatch only picks the half and length
     try {
         for (int channel = 0; channel < getTotalNumInputChannels(); ++channel)
         {
-            
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, inputBatchData[channel].data(), inputBatchData[channel].size(),
-         inputShape.data(), inputShape.size()));
-        
-        DBG("inputBatchData.size(): " + juce::String((int)inputBatchData[channel].size()));
-        DBG("inputShape: [" + juce::String((int)inputShape[0]) + ", " +
-                             juce::String((int)inputShape[1]) + ", " +
-                             juce::String((int)inputShape[2]) + "]");
-        DBG("Expected tensor size: " + juce::String((int)(inputShape[0] * inputShape[1] * inputShape[2])));
-               
-        DBG("condBatchData.size(): " + juce::String((int)kBatchData.size()));
-        DBG("condShape: [" + juce::String((int)condShape[0]) + ", " +
-                             juce::String((int)condShape[1]) + ", " +
-                             juce::String((int)condShape[2]) + "]");
-        
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, kBatchData.data(), kBatchData.size(),
-         condShape.data(), condShape.size()));
-        
-        inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-         memoryInfo, vBatchData.data(), vBatchData.size(),
-         condShape.data(), condShape.size()));
+            outputBatchData[channel].resize(samplesPerBlock, 0.0f);
 
-        DBG("Expected tensor size: " + juce::String((int)(condShape[0] * condShape[1] * condShape[2])));
-                 
+            for (int half = 0; half < 2; ++half)
+            {
+                auto& bindings = channelBindings[channel][half];
+                bindings.clear();
+
+                for (int length : blockLengths)
+                {
+                    std::vector<int64_t> inputShape = {1, static_cast<int64_t>(length), 1};
+                    std::vector<int64_t> condShape = {1, static_cast<int64_t>(length), 1};
+
+                    bindings.emplace_back();
+                    auto& binding = bindings.back();
+                    auto& inputs = binding.inputs;
+                    auto& outputs = binding.outputs;
+
+                    inputs.push_back(Ort::Value::CreateTensor<float>(
+                     memoryInfo, inputBatchData[channel].data(), length,
+                     inputShape.data(), inputShape.size()));
+
+                    for (auto* control : { &kBatchData, &vBatchData })
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                         memoryInfo, control->data(), length,
+                         condShape.data(), condShape.size()));
+
+                    outputs.push_back(Ort::Value::CreateTensor<float>(
+                     memoryInfo, outputBatchData[channel].data(), length,
+                     inputShape.data(), inputShape.size()));
+
+                    // State tensors read this half, the new ones go to the other
+                    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                    {
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(half, stateIdx, channel), stateRows * STATE_SIZE,
+                            stateShape.data(), stateShape.size()));
+
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, stateIdx, channel), SCAN_STATE_SIZE,
+                            newStateShape.data(), newStateShape.size()));
+                    }
+
+                    binding.io = std::make_unique<Ort::IoBinding>(*model.session);
+
+                    for (size_t i = 0; i < inputs.size(); ++i)
+                        binding.io->BindInput(inputNameCStr[i], inputs[i]);
+
+                    for (size_t i = 0; i < outputs.size(); ++i)
+                        binding.io->BindOutput(outputNameCStr[i], outputs[i]);
+                }
+            }
 
-            // Create state tensors (1 x 64 each)
-            for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
-              {
-                  inputTensor[channel].push_back(Ort::Value::CreateTensor<float>(
-                      memoryInfo,
-                      channelStates[stateIdx][channel].data(),
-                      channelStates[stateIdx][channel].size(),
-                      stateShape.data(),
-                      stateShape.size()));
-              }
+            channelIo[channel] = { inputBatchData[channel].data(), outputBatchData[channel].data(), samplesPerBlock };
         }
 
+        // Both channels in one tensor per input, when the model allows it
+        for (int half = 0; half < 2; ++half)
+            batchedBindings[half].clear();
+
+        if (model.takesBatch && getTotalNumOutputChannels() == 2)
+        {
+            std::vector<int64_t> batchedStateShape = {2, stateRows, STATE_SIZE}; // the scan state is batch-first
+            std::vector<int64_t> batchedNewStateShape = {2, SCAN_STATE_SIZE / STATE_SIZE, STATE_SIZE};
+
+            batchedInputData.resize(2 * samplesPerBlock, 0.0f);
+            batchedOutputData.resize(2 * samplesPerBlock, 0.0f);
+
+            for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                batchedStates[stateIdx].resize(2 * STATE_SIZE, 0.0f);
+
+            for (int half = 0; half < 2; ++half)
+            {
+                for (int length : blockLengths)
+                {
+                    // The channels sit back to back at the block's length
+                    std::vector<int64_t> batchedShape = {2, static_cast<int64_t>(length), 1};
+
+                    batchedBindings[half].emplace_back();
+                    auto& binding = batchedBindings[half].back();
+                    auto& inputs = binding.inputs;
+                    auto& outputs = binding.outputs;
+
+                    inputs.push_back(Ort::Value::CreateTensor<float>(
+                        memoryInfo, batchedInputData.data(), 2 * length,
+                        batchedShape.data(), batchedShape.size()));
+
+                    for (auto* control : { &kBatchData, &vBatchData })
+                        inputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, control->data(), 2 * length,
+                            batchedShape.data(), batchedShape.size()));
+
+                    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                        inputs.push_back(model.carriesScanRows
+                            ? Ort::Value::CreateTensor<float>(
+                                memoryInfo, stateArena.get(half, stateIdx, 0), 2 * SCAN_STATE_SIZE,
+                                batchedStateShape.data(), batchedStateShape.size())
+                            : Ort::Value::CreateTensor<float>(
+                                memoryInfo, batchedStates[stateIdx].data(), batchedStates[stateIdx].size(),
+                                batchedStateShape.data(), batchedStateShape.size()));
+
+                    outputs.push_back(Ort::Value::CreateTensor<float>(
+                        memoryInfo, batchedOutputData.data(), 2 * length,
+                        batchedShape.data(), batchedShape.size()));
+
+                    // A slot holds both channels back to back, which is the batched layout
+                    for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                        outputs.push_back(Ort::Value::CreateTensor<float>(
+                            memoryInfo, stateArena.get(1 - half, stateIdx, 0), 2 * SCAN_STATE_SIZE,
+                            batchedNewStateShape.data(), batchedNewStateShape.size()));
+
+                    binding.io = std::make_unique<Ort::IoBinding>(*model.session);
+
+                    for (size_t i = 0; i < inputs.size(); ++i)
+                        binding.io->BindInput(inputNameCStr[i], inputs[i]);
+
+                    for (size_t i = 0; i < outputs.size(); ++i)
+                        binding.io->BindOutput(outputNameCStr[i], outputs[i]);
+                }
+            }
+
+            DBG("Stereo runs as one batch of 2");
+        }
 
      DBG("Tensors created successfully");
     }
     catch (const std::exception& e) {
      DBG("Failed to create tensors: " + juce::String(e.what()));
+     blockLengths.clear();
+    }
+}
+
+// Reserves the arena the bindings for maxBlockSize need. The first time the
+// model sees a block size, every bound length runs once with the arena
+// measuring, and the size is cached with the model; ONNX Runtime also plans
+// its memory for each shape on these calls rather than on the audio thread.
+// The states they leave behind are cleared. Runs on the loader thread, under
+// preparationLock.
+void NeuralPianoAudioProcessor::sizeRealtimeArena(const LoadedModel& model)
+{
+    const auto cached = model.arenaBytes.find(maxBlockSize);
+
+    if (cached != model.arenaBytes.end())
+    {
+        realtimeArena.reserve(cached->second);
+        return;
+    }
+
+    realtimeArena.beginMeasuring();
+    bool measured = false;
+
+    try
+    {
+        const neural::RealtimeArena::Scope allocations(realtimeArena);
+
+        for (size_t lengthIdx = 0; lengthIdx < blockLengths.size(); ++lengthIdx)
+        {
+            model.session->Run(runOptions, *channelBindings[0][0][lengthIdx].io);
+
+            if (! batchedBindings[0].empty())
+                model.session->Run(runOptions, *batchedBindings[0][lengthIdx].io);
+        }
+
+        measured = true;
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Failed to size the real-time arena: " + juce::String(e.what()));
+    }
+
+    realtimeArena.reserveMeasured();
+    stateArena.clear();
+
+    if (measured)
+        model.arenaBytes[maxBlockSize] = realtimeArena.getCapacity();
+
+    DBG("Real-time arena: " + juce::String((int) realtimeArena.getCapacity()) + " bytes");
+}
+
+// Points both halves' full-length bindings of a channel at other input /
+// output memory. Creating the views allocates, so it only happens when the
+// memory or the length changed.
+void NeuralPianoAudioProcessor::bindChannelIo(int channel, float* input, float* output, int numSamples)
+{
+    auto& io = channelIo[channel];
+
+    if (io.input == input && io.output == output && io.numSamples == numSamples)
+        return;
+
+    std::vector<int64_t> shape = {1, static_cast<int64_t>(numSamples), 1};
+
+    for (int half = 0; half < 2; ++half)
+    {
+        auto& binding = channelBindings[channel][half][0];
+        auto& inputs = binding.inputs;
+        auto& outputs = binding.outputs;
+
+        inputs[0] = Ort::Value::CreateTensor<float>(memoryInfo, input, numSamples, shape.data(), shape.size());
+        binding.io->BindInput(inputNameCStr[0], inputs[0]);
+
+        // The controls hold at least a prepared block, so a shorter view of them fits
+        if (numSamples != io.numSamples)
+        {
+            size_t i = 1;
+
+            for (auto* control : { &kBatchData, &vBatchData })
+            {
+                inputs[i] = Ort::Value::CreateTensor<float>(memoryInfo, control->data(), numSamples, shape.data(), shape.size());
+                binding.io->BindInput(inputNameCStr[i], inputs[i]);
+                ++i;
+            }
+        }
+
+        outputs[0] = Ort::Value::CreateTensor<float>(memoryInfo, output, numSamples, shape.data(), shape.size());
+        binding.io->BindOutput(outputNameCStr[0], outputs[0]);
     }
+
+    io = { input, output, numSamples };
 }
+#endif
 
 void NeuralPianoAudioProcessor::releaseResources()
 {
@@ -247,6 +528,13 @@ void NeuralPianoAudioProcessor::releaseResources()
     inputBatchData[1].clear();
     kBatchData.clear();
     vBatchData.clear();
+
+   #if NEURAL_USE_ONNXRUNTIME
+    if (shadowComparisonEnabled)
+        DBG("Shadow comparison: " + juce::String(divergence.getSummary()));
+
+    DBG("Shared ONNX Runtime arena: " + juce::String(neural::OrtSessionCache::getInstance().getSharedArenaUsage().toString()));
+   #endif
 }
 
 
@@ -284,70 +572,291 @@ void NeuralPianoAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
+
+    // Audio passes through until the loader thread has published the model,
+    // and while it measures the arena for a new block size
+    const auto* model = modelLoader.get();
+
+    if (model == nullptr || measuringArena)
+        return;
+
+    // Hosts may pass more samples than they announced in prepareToPlay; the
+    // buffers and tensors hold maxBlockSize, so longer blocks go in pieces
+    if (buffer.getNumSamples() > maxBlockSize && maxBlockSize > 0)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        {
+            juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start,
+                                           std::min(maxBlockSize, buffer.getNumSamples() - start));
+            processBlock(piece, midiMessages);
+        }
+        return;
+    }
         
     // Process with ML model if loaded
-    if (modelLoaded)
+   #if NEURAL_USE_ONNXRUNTIME
+    if (shadowComparisonEnabled && model->sessionLoaded && model->nativeLoaded)
+    {
+        processWithShadowComparison(buffer);
+        return;
+    }
+   #endif
+
+    if (model->nativeLoaded && (inferenceBackend == neural::InferenceBackend::native || ! model->sessionLoaded))
+    {
+        processWithNativeModel(buffer);
+    }
+   #if NEURAL_USE_ONNXRUNTIME
+    else if (model->sessionLoaded)
     {
         processWithModelBatch(buffer);
     }
+   #endif
 }
 
+#if NEURAL_USE_ONNXRUNTIME
 void NeuralPianoAudioProcessor::processWithModelBatch(juce::AudioBuffer<float>& buffer)
 {
     
     const int numChannels = buffer.getNumChannels();
     const int numSamples = buffer.getNumSamples();
+
+    // Read once, so a toggle from another thread cannot change the mode mid-block
+    const bool zeroCopy = zeroCopyEnabled;
+
+    if (blockLengths.empty())
+        return;
+
+    // Whatever Run() allocates comes from the arena reserved for it
+    const neural::RealtimeArena::Scope allocations(realtimeArena);
+
     float v = *parameters.getRawParameterValue("v");
     float k = *parameters.getRawParameterValue("k");
 
     std::fill(vBatchData.begin(), vBatchData.end(), v);
     std::fill(kBatchData.begin(), kBatchData.end(), k);
 
+    // The batched tensors pack both channels, so zero-copy mode skips them
+    const bool batched = numChannels == 2 && ! batchedBindings[0].empty() && ! zeroCopy;
+
+    // Zero-copy mode views the whole host block at once; otherwise the block
+    // runs through the prepared lengths, longest first, so every call sees
+    // exactly the samples it is given
+    for (int start = 0; start < numSamples;)
+    {
+        const size_t lengthIdx = zeroCopy ? 0 : getBlockLengthIndex(numSamples - start);
+        const int length = zeroCopy ? numSamples : blockLengths[lengthIdx];
+
+        if (batched)
+            processWithModelBatchedChannels(buffer, start, lengthIdx);
+        else
+            processWithModelChunk(buffer, start, length, lengthIdx, zeroCopy);
+
+        start += length;
+    }
+}
+
+void NeuralPianoAudioProcessor::processWithModelChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples, size_t lengthIdx, bool zeroCopy)
+{
+    const int half = stateArena.getCurrentHalf();
+
     // Process each channel independently
-    for (int channel = 0; channel < numChannels; ++channel)
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
     {
-        float* channelData = buffer.getWritePointer(channel);
+        float* channelData = buffer.getWritePointer(channel) + start;
         
         try
         {
-            std::copy(channelData, channelData + numSamples, inputBatchData[channel].begin());
-            
-            // Perform inference
-            auto outputTensor = ortSession->Run(
-                   Ort::RunOptions{nullptr},
-                   inputNameCStr.data(),
-                   inputTensor[channel].data(),
-                   inputNameCStr.size(), // Number of inputs
-                   outputNameCStr.data(),
-                   outputNameCStr.size() // Number of outputs
-               );
-            const float* outputData = outputTensor[0].GetTensorMutableData<float>();
-            
-            // Update states with new state values
-            for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+            if (zeroCopy)
             {
-                const float* newStateData = outputTensor[stateIdx + 1].GetTensorMutableData<float>();
-                std::copy(newStateData, newStateData + STATE_SIZE,
-                         channelStates[stateIdx][channel].begin());
-                
-                //DBG("newStateData: " + juce::String(*newStateData));
-
+                bindChannelIo(channel, channelData,
+                              modelOutputCanOverwriteInput ? channelData : outputBatchData[channel].data(),
+                              numSamples);
             }
-            for (int i = 0; i < numSamples; ++i)
+            else
             {
-                channelData[i] = softLimit(outputData[i]);
-                DBG("channelData: " + juce::String(channelData[i]));
+                if (lengthIdx == 0)
+                    bindChannelIo(channel, inputBatchData[channel].data(), outputBatchData[channel].data(), blockLengths[0]);
+
+                std::copy(channelData, channelData + numSamples, inputBatchData[channel].begin());
             }
+            
+            // Perform inference; the new states land in the arena's other half
+            modelLoader.get()->session->Run(runOptions, *channelBindings[channel][half][lengthIdx].io);
+
+            softLimit(zeroCopy ? channelIo[channel].output : outputBatchData[channel].data(), channelData, numSamples);
         }
         catch (const std::exception& e)
         {
             DBG("Error processing batch: " + juce::String(e.what()));
         }
     }
+
+    // Every channel has written its half, so the new states become current
+    stateArena.swap();
+}
+
+void NeuralPianoAudioProcessor::processWithModelBatchedChannels(juce::AudioBuffer<float>& buffer, int start, size_t lengthIdx)
+{
+    const int numSamples = blockLengths[lengthIdx];
+
+    try
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const float* channelData = buffer.getReadPointer(channel) + start;
+            std::copy(channelData, channelData + numSamples, batchedInputData.begin() + channel * numSamples);
+
+            // The exported h is the first row of each channel's scan state, so it is the one thing gathered
+            if (! modelLoader.get()->carriesScanRows)
+                for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+                    std::copy(channelState(stateIdx, channel), channelState(stateIdx, channel) + STATE_SIZE,
+                              batchedStates[stateIdx].begin() + channel * STATE_SIZE);
+        }
+
+        modelLoader.get()->session->Run(runOptions, *batchedBindings[stateArena.getCurrentHalf()][lengthIdx].io);
+        stateArena.swap();
+
+        for (int channel = 0; channel < 2; ++channel)
+            softLimit(batchedOutputData.data() + channel * numSamples, buffer.getWritePointer(channel) + start, numSamples);
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Error processing batch: " + juce::String(e.what()));
+    }
+}
+
+void NeuralPianoAudioProcessor::processWithShadowComparison(juce::AudioBuffer<float>& buffer)
+{
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+    const bool nativeIsSelected = inferenceBackend == neural::InferenceBackend::native;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        shadowBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+    juce::AudioBuffer<float> shadow(shadowBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+    // The selected engine processes the block as usual...
+    saveStates(shadowStartStates);
+
+    if (nativeIsSelected)
+        processWithNativeModel(buffer);
+    else
+        processWithModelBatch(buffer);
+
+    // ...then the other one repeats it from the same starting point
+    saveStates(shadowPrimaryStates);
+    restoreStates(shadowStartStates);
+
+    if (nativeIsSelected)
+        processWithModelBatch(shadow);
+    else
+        processWithNativeModel(shadow);
+
+    // Tensor indices follow outputNameCStr
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        divergence.compare(0, buffer.getReadPointer(channel), shadow.getReadPointer(channel), numSamples);
+
+        for (int stateIdx = 0; stateIdx < NUM_STATES; ++stateIdx)
+            divergence.compare(1 + stateIdx, shadowPrimaryStates.current(stateIdx, channel),
+                               channelState(stateIdx, channel), STATE_SIZE);
+    }
+
+    divergence.blockCompared();
+
+    // The selected engine's states carry on
+    restoreStates(shadowPrimaryStates);
+}
+
+// Copies into memory of the same size, so what the ONNX bindings point at
+// stays where it is
+void NeuralPianoAudioProcessor::saveStates(StateSnapshot& snapshot) const
+{
+    snapshot.copyFrom(stateArena);
 }
 
+void NeuralPianoAudioProcessor::restoreStates(const StateSnapshot& snapshot)
+{
+    stateArena.copyFrom(snapshot);
+}
+#endif
 
 
+
+void NeuralPianoAudioProcessor::processWithNativeModel(juce::AudioBuffer<float>& buffer)
+{
+    float v = *parameters.getRawParameterValue("v");
+    float k = *parameters.getRawParameterValue("k");
+    float body = *parameters.getRawParameterValue("body");
+
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+
+    // The scan restarts its sums on every call, as the graph does on every
+    // Run(), so the block goes through in the calls processWithModelBatch makes
+   #if NEURAL_USE_ONNXRUNTIME
+    if (modelLoader.get()->sessionLoaded && ! blockLengths.empty() && ! zeroCopyEnabled)
+    {
+        for (int start = 0; start < numSamples;)
+        {
+            const int length = blockLengths[getBlockLengthIndex(numSamples - start)];
+            juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), numChannels, start, length);
+
+            nativeKernel(*this, piece.getArrayOfWritePointers(), numChannels, length, v, k, body);
+            start += length;
+        }
+        return;
+    }
+   #endif
+
+    nativeKernel(*this, buffer.getArrayOfWritePointers(), numChannels, numSamples, v, k, body);
+}
+
+template <typename Ops>
+void NeuralPianoAudioProcessor::NativeKernel::run(NeuralPianoAudioProcessor& processor, float* const* channels,
+                                                  int numChannels, int numSamples, float v, float k, float body)
+{
+    auto& p = processor;
+
+    std::fill(p.vBatchData.begin(), p.vBatchData.end(), v);
+    std::fill(p.kBatchData.begin(), p.kBatchData.end(), k);
+
+    const auto& model = *p.modelLoader.get();
+
+   #if NEURAL_USE_GENERATED_MODEL
+    const auto& upright = generated::neuralPiano::weights; // constexpr, so the compiler can fold it in
+   #else
+    const auto& upright = model.native->getWeights();
+   #endif
+
+    // One model either way: the upright weights as loaded, or a blend towards the grand
+    const auto& weights = (body > 0.0f && model.bodyMorph.isReady()) ? model.bodyMorph.get(body) : upright;
+
+    // Offline bounces of long blocks are split across every core
+    const bool renderInParallel = p.isNonRealtime() && neural::ScanSegments::worthSplitting(numSamples, *p.renderPool);
+
+    // Same states as the ONNX path, so the backend can be switched mid-stream
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* channelData = channels[channel];
+
+        if (renderInParallel)
+            NativeModel::renderParallel<Ops>(*p.renderPool, weights, channelData, p.kBatchData.data(), p.vBatchData.data(),
+                                             channelData, numSamples,
+                                             p.channelState(0, channel),
+                                             p.nativeStreamState(channel));
+        else
+            NativeModel::run<Ops>(weights, channelData, p.kBatchData.data(), p.vBatchData.data(),
+                                  channelData, numSamples,
+                                  p.channelState(0, channel),
+                                  p.nativeStreamState(channel));
+
+        neural::fastmath::softLimit<Ops>(channelData, channelData, numSamples, softLimitThreshold);
+    }
+}
+
 //==============================================================================
 bool NeuralPianoAudioProcessor::hasEditor() const
 {
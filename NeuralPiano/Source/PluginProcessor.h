@@ -9,7 +9,24 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <onnxruntime_cxx_api.h>
+#include <map>
+#include <mutex>
+#include "../../Common/InferenceBackend.h"
+#include "../../Common/FastMath.h"
+#include "../../Common/CpuDispatch.h"
+#include "../../Common/ParallelScan.h"
+#include "../../Common/DivergenceTracker.h"
+#include "../../Common/WeightMorph.h"
+#include "../../Common/StateArena.h"
+#include "../../Common/BackgroundLoader.h"
+#if NEURAL_USE_ONNXRUNTIME
+ #include "../../Common/OrtSessionCache.h"
+#endif
+#include "NativePianoModel.h"
+#if NEURAL_USE_GENERATED_MODEL
+ #include "Generated/NeuralPianoWeights.h"
+ #include "Generated/NeuralPianoGrandWeights.h"
+#endif
 
 //==============================================================================
 /**
@@ -56,59 +73,267 @@ public:
   
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
 
+    // Switches between ONNX Runtime and the built-in model; safe to call while playing
+    void setInferenceBackend (neural::InferenceBackend newBackend) { inferenceBackend = newBackend; }
+    neural::InferenceBackend getInferenceBackend() const { return inferenceBackend; }
+
+    // Whether blocks go through the native engine: when it is selected, or when
+    // no session could be created. Only then does the "body" parameter apply.
+    bool isNativeEngineActive() const
+    {
+        const auto* model = modelLoader.get();
+
+        if (model != nullptr && model->nativeLoaded && ! model->sessionLoaded)
+            return true;
+
+        return inferenceBackend == neural::InferenceBackend::native;
+    }
+
+    // Instruction set the native kernels were picked for when the plugin loaded
+    neural::SimdLevel getSimdLevel() const { return simdLevel; }
+
+   #if NEURAL_USE_ONNXRUNTIME
+    // Opt-in check of one engine against the other: every block also goes
+    // through the engine that is not selected, from the same input and states,
+    // and the largest differences on the output and on each state the ONNX
+    // session returns are recorded. Doubles the processing cost.
+    void setShadowComparisonEnabled (bool shouldCompare) { shadowComparisonEnabled = shouldCompare; }
+    bool isShadowComparisonEnabled() const { return shadowComparisonEnabled; }
+    neural::DivergenceTracker& getDivergence() { return divergence; }
+
+    // Zero-copy mode: ONNX Runtime reads each channel straight from the host's
+    // buffer and writes its output back into it, instead of going through
+    // inputBatchData and outputBatchData. The tensor views are recreated (which
+    // allocates) only when the host passes another pointer or length, so the
+    // mode suits offline rendering of large buffers. Stereo then takes the
+    // per-channel calls.
+    void setZeroCopyEnabled (bool shouldBindHostBuffer) { zeroCopyEnabled = shouldBindHostBuffer; }
+    bool isZeroCopyEnabled() const { return zeroCopyEnabled; }
+
+    // Allocations inside Run() that did not fit in the arena reserved for them
+    // and went to the heap on the audio thread. ONNX Runtime's pool threads are
+    // only counted process-wide, in OrtSessionCache::getSharedArenaUsage()
+    // (see Common/RealtimeAllocator.h).
+    uint64_t getRealtimeHeapFallbacks() const { return realtimeArena.getHeapFallbacks(); }
+
+    // The arena's size, the most of it one Run() has used, and the allocations it served
+    size_t getRealtimeArenaCapacity() const { return realtimeArena.getCapacity(); }
+    size_t getRealtimeArenaHighWaterMark() const { return realtimeArena.getHighWaterMark(); }
+    uint64_t getRealtimeArenaAllocations() const { return realtimeArena.getNumAllocations(); }
+   #endif
+
 private:
     //==============================================================================
     
-    float softLimit(float input, float threshold = 0.6f)
+    // Samples beyond the threshold are replaced by their tanh, a SIMD register
+    // at a time; output may alias input
+    void softLimit(const float* input, float* output, int numSamples)
     {
-        if (std::abs(input) <= threshold)
-            return input;
-        
-        //float sign = std::copysign(1.0f, input);
-        //float excess = std::abs(input) - threshold;
-        //float limitedExcess = threshold * std::tanh(excess / threshold);
-        
-        //return sign * (threshold + limitedExcess);*/
-        return std::tanh(input);
+        outputLimiter(input, output, numSamples, softLimitThreshold);
     }
+
+    static constexpr float softLimitThreshold = 0.6f;
+
+    // Conditioning fill, model and output limiter of the native path, compiled
+    // once per instruction set (see CpuDispatch.h)
+    struct NativeKernel
+    {
+        template <typename Ops>
+        static void run(NeuralPianoAudioProcessor& processor, float* const* channels, int numChannels, int numSamples,
+                        float v, float k, float body);
+    };
+
+    const neural::SimdLevel simdLevel = neural::getSimdLevel();
+    neural::SimdDispatch<NativeKernel>::Function<NeuralPianoAudioProcessor&, float* const*, int, int,
+                                                 float, float, float> nativeKernel = nullptr;
+    neural::SimdDispatch<neural::SoftLimitKernel>::Function<const float*, float*, int, float> outputLimiter = nullptr;
+
+    // Worker threads for offline rendering, shared by every instance and
+    // started on the first long non-realtime block
+    std::shared_ptr<neural::TaskPool> renderPool { neural::TaskPool::getShared() };
     
     juce::AudioProcessorValueTreeState parameters;
     
+   #if NEURAL_USE_ONNXRUNTIME
     // ONNX Runtime components
-    std::unique_ptr<Ort::Env> ortEnv;
-    Ort::AllocatorWithDefaultOptions ortAllocator;
-    std::unique_ptr<Ort::SessionOptions> ortSessionOptions;
+    neural::OrtSessionSettings sessionSettings;     // instances with equal settings share a session
     Ort::MemoryInfo memoryInfo{Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU)};
-    std::unique_ptr<Ort::Session> ortSession;
+    Ort::RunOptions runOptions;
 
     // Model information
     std::vector<const char*> inputNameCStr = {"input", "k", "v", "h"};
     std::vector<const char*> outputNameCStr = {"output", "new_h"};
+   #endif
   
     // State management
     static const int STATE_SIZE = 64;
     static const int NUM_STATES = 1;
     
-    bool modelLoaded = false;
+    using NativeModel = NativePianoModel<STATE_SIZE>;
+
+    // Everything read from the model files. The loader thread fills it in and
+    // publishes it once; it does not change after that.
+    struct LoadedModel
+    {
+       #if NEURAL_USE_ONNXRUNTIME
+        std::shared_ptr<Ort::Session> session;   // from neural::OrtSessionCache
+        bool takesBatch = false;
+        bool carriesScanRows = false;            // h takes both scan rows
+
+        // The arena size the bindings for each block size needed, measured
+        // once on the loader thread. Only touched under preparationLock.
+        mutable std::map<int, size_t> arenaBytes;
+       #endif
+        bool sessionLoaded = false;
+
+        // Native selective-scan path, fed with the weights from the same .onnx file
+        std::unique_ptr<NativeModel> native;
+        bool nativeLoaded = false;
+
+        // The "body" parameter morphs the native model's weights from the upright
+        // (0) to the grand (1) recording, one precomputed set per 1/32 step.
+        // ONNX Runtime keeps running the upright model.
+        neural::WeightMorph<NativeModel::Weights, 32> bodyMorph;
+    };
+
+    // Started by the constructor; processBlock passes audio through until it
+    // has published the model
+    neural::BackgroundLoader<LoadedModel> modelLoader;
+
+    // Held while prepareToPlay resizes the buffers and while the loader
+    // creates the bindings and publishes, so the bindings always match them
+    std::mutex preparationLock;
 
-    // Per-channel states (for stereo support)
-    std::vector<std::vector<float>> channelStates[NUM_STATES]; // [state_index][channel][state_data]
-    std::vector<int64_t> stateShape = {1, 1, STATE_SIZE}; // 1x1x8 shape for each state
+    // Set while the loader thread measures the arena for a new block size.
+    // That runs the session on the bindings and the states, so processBlock
+    // passes the audio through meanwhile.
+    std::atomic<bool> measuringArena { false };
+
+    std::atomic<neural::InferenceBackend> inferenceBackend { neural::InferenceBackend::native };
+
+    // Per-channel states (for stereo support), in two halves that swap roles
+    // after each ONNX Runtime call. new_h returns the scan rows of both inner
+    // channels, so a slot holds SCAN_STATE_SIZE floats per channel. The
+    // exported h views the first STATE_SIZE of them; models rewritten by
+    // Tools/expose_conv_history.py read both back (LoadedModel::carriesScanRows).
+    static const int SCAN_STATE_SIZE = NativeModel::ScanBlock::scanStateSize;
+    neural::StateArena stateArena;
+
+    float* channelState(int stateIdx, int channel) const { return stateArena.current(stateIdx, channel); }
+
+    // The native path's stream state: the second scan row, right after the
+    // first in the slot (the conv kernel is 1, so there is no history), when
+    // the session's model carries it too; the shipped model does not
+    static_assert (NativeModel::ScanBlock::streamStateSize == SCAN_STATE_SIZE - STATE_SIZE, "Only scan rows follow");
+
+    float* nativeStreamState(int channel) const
+    {
+       #if NEURAL_USE_ONNXRUNTIME
+        if (modelLoader.get()->carriesScanRows)
+            return channelState(0, channel) + STATE_SIZE;
+       #endif
+        juce::ignoreUnused(channel);
+        return nullptr;
+    }
     
-    std::vector<Ort::Value> inputTensor[2];
+    // Largest block every buffer and tensor holds; processBlock splits longer ones
+    int maxBlockSize = 0;
+
+   #if NEURAL_USE_ONNXRUNTIME
+    // Tensors and their binding for one block length: the inputs read one half
+    // of the arena and the session writes the new states, and the output
+    // samples, into preallocated memory, so Run() returns nothing
+    struct Binding
+    {
+        std::vector<Ort::Value> inputs;
+        std::vector<Ort::Value> outputs;
+        std::unique_ptr<Ort::IoBinding> io;
+    };
+
+    // Lengths there are bindings for, longest first: maxBlockSize, every
+    // multiple of a granule of about sqrt(maxBlockSize) below it, then every
+    // length below the granule. A shorter block runs as at most two calls of
+    // these exact shapes, so nothing is created on the audio thread and no
+    // call is padded (the states must end on the block's last sample).
+    std::vector<int> blockLengths;
+
+    // Index of the longest of blockLengths that fits in numSamples
+    size_t getBlockLengthIndex(int numSamples) const
+    {
+        size_t lengthIdx = 0;
+        while (blockLengths[lengthIdx] > numSamples)
+            ++lengthIdx;
+        return lengthIdx;
+    }
+
+    std::vector<Binding> channelBindings[2][2]; // [channel][half][length]
+    std::vector<float> outputBatchData[2];
+
+    // Memory each channel's full-length bindings read the input from and write
+    // the output to, so bindChannelIo only recreates the views when it changes
+    struct ChannelIo
+    {
+        float* input = nullptr;
+        float* output = nullptr;
+        int numSamples = 0;
+    };
+    ChannelIo channelIo[2];
+
+    // Zero-copy mode may bind the output to the input's memory: both nodes reading
+    // "input" (a Shape and the in-projection) run before the output layer's Add
+    static constexpr bool modelOutputCanOverwriteInput = true;
+    std::atomic<bool> zeroCopyEnabled { false };
+
+    // Where Run() allocates on the audio thread, sized when the bindings are made
+    neural::RealtimeArena realtimeArena;
+
+    // Stereo through one Run(), the channels packed on the batch axis, for models
+    // whose batch dimension is dynamic (see Tools/make_batch_dynamic.py). The new
+    // states go straight to the arena. A model that takes both scan rows reads
+    // them from there too; otherwise the first rows are gathered into
+    // batchedStates before each call.
+    std::vector<Binding> batchedBindings[2]; // [half][length]
+    std::vector<float> batchedInputData;
+    std::vector<float> batchedOutputData;
+    std::vector<float> batchedStates[NUM_STATES];
+   #endif
 
     // Batch processing buffers
     std::vector<float> inputBatchData[2];
+    // The controls hold two blocks, so the batched tensors can cover both channels
     std::vector<float> kBatchData;
     std::vector<float> vBatchData;
 
+   #if NEURAL_USE_ONNXRUNTIME
+    // Shadow comparison: the block's input and the states before and after the
+    // selected engine ran, kept at full size so nothing allocates while comparing
+    using StateSnapshot = neural::StateArena;
+
+    std::atomic<bool> shadowComparisonEnabled { neural::isShadowComparisonRequested() };
+    neural::DivergenceTracker divergence;
+    juce::AudioBuffer<float> shadowBuffer;
+    StateSnapshot shadowStartStates, shadowPrimaryStates;
+   #endif
 
     // Methods
-    void initializeOnnxRuntime();
-    void getModelInputOutputInfo();
-    void loadModel(const juce::String& modelPath);
+    std::unique_ptr<LoadedModel> loadModel(const juce::String& modelPath);
+   #if NEURAL_USE_ONNXRUNTIME
     void processWithModelBatch(juce::AudioBuffer<float>& buffer);
+    void processWithModelChunk(juce::AudioBuffer<float>& buffer, int start, int numSamples, size_t lengthIdx, bool zeroCopy);
+    void processWithModelBatchedChannels(juce::AudioBuffer<float>& buffer, int start, size_t lengthIdx);
+   #endif
+    void processWithNativeModel(juce::AudioBuffer<float>& buffer);
+   #if NEURAL_USE_ONNXRUNTIME
+    void processWithShadowComparison(juce::AudioBuffer<float>& buffer);
+    void saveStates(StateSnapshot& snapshot) const;
+    void restoreStates(const StateSnapshot& snapshot);
+   #endif
     void initializeStates(int numChannels);
+   #if NEURAL_USE_ONNXRUNTIME
+    void createBindings(const LoadedModel& model, int samplesPerBlock);
+    void bindChannelIo(int channel, float* input, float* output, int numSamples);
+    void sizeRealtimeArena(const LoadedModel& model);
+   #endif
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NeuralPianoAudioProcessor)
 };
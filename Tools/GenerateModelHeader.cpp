@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+    GenerateModelHeader.cpp
+
+    Bakes one of the shipped models into a C++ header: the weights become a
+    constexpr initializer of the native kernel's Weights aggregate, already
+    validated and repacked by the same load() code the plugins use, plus a
+    process() function bound to them. Compiled with NEURAL_USE_GENERATED_MODEL=1,
+    a plugin runs that instead of loading the .onnx file at all, and the
+    compiler is free to constant-fold and unroll the fixed-size recurrences.
+
+    Build and run from the repository root:
+
+        c++ -std=c++17 -O2 Tools/GenerateModelHeader.cpp -o GenerateModelHeader
+        ./GenerateModelHeader tape-preamp Hybrid/Models/CL1BTapePreamp__lstm_8.onnx Hybrid/Source/Generated/TapePreampLstmWeights.h
+        ./GenerateModelHeader cl1b NeuralCL1B/Models/CL1B_nof.onnx NeuralCL1B/Source/Generated/CL1BWeights.h
+        ./GenerateModelHeader neural-piano NeuralPiano/Models/NeuralPiano_up.onnx NeuralPiano/Source/Generated/NeuralPianoWeights.h
+        ./GenerateModelHeader neural-piano-grand NeuralPiano/Models/NeuralPiano_grand.onnx NeuralPiano/Source/Generated/NeuralPianoGrandWeights.h
+        ./GenerateModelHeader upright-piano NeuralPiano/Models/UprightPiano.onnx NeuralPiano/Source/Generated/UprightPianoWeights.h
+
+  ==============================================================================
+*/
+
+#include "../Common/LstmFilmModel.h"
+#include "../NeuralCL1B/Source/NativeCL1BModel.h"
+#include "../NeuralPiano/Source/NativePianoModel.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+namespace
+{
+
+using FloatVisitor = std::function<void (const float*, int)>;
+
+struct Target
+{
+    const char* name;
+    const char* modelType;          // as spelled in the generated header
+    const char* include;            // relative to <Plugin>/Source/Generated
+    const char* nameSpace;
+    const char* parameters;         // process() parameter list
+    const char* arguments;          // forwarded to Model::run after the weights
+    std::function<bool (const neural::OnnxInitializers&, const FloatVisitor&)> loadAndVisit;
+};
+
+template <typename Model, typename... LoadArgs>
+auto makeLoader (LoadArgs... loadArgs)
+{
+    return [=] (const neural::OnnxInitializers& initializers, const FloatVisitor& visit)
+    {
+        auto model = std::make_unique<Model>();
+
+        if (! model->load (initializers, loadArgs...))
+            return false;
+
+        model->getWeights().visitArrays (visit);
+        return true;
+    };
+}
+
+const char* lstmParameters = "const float* input, const float* const* conditioning,\n"
+                             "                     float* output, int numSamples, float* h, float* c";
+const char* lstmArguments  = "input, conditioning, output, numSamples, h, c";
+
+const Target targets[] =
+{
+    { "tape-preamp", "neural::TapePreampLstmModel", "../../../Common/LstmFilmModel.h", "tapePreampLstm",
+      lstmParameters, lstmArguments,
+      makeLoader<neural::TapePreampLstmModel> (neural::tapePreampLstmWeights) },
+
+    { "upright-piano", "neural::UprightPianoLstmModel", "../../../Common/LstmFilmModel.h", "uprightPianoLstm",
+      lstmParameters, lstmArguments,
+      makeLoader<neural::UprightPianoLstmModel> (neural::uprightPianoLstmWeights) },
+
+    { "cl1b", "NativeCL1BModel<6, 4>", "../NativeCL1BModel.h", "cl1b",
+      "const float* input,\n"
+      "                     const float* threshold, const float* ratio,\n"
+      "                     const float* attack, const float* release,\n"
+      "                     float* output, int numSamples,\n"
+      "                     float* states1, float* states2, float* hidden,\n"
+      "                     float* stream1 = nullptr, float* stream2 = nullptr",
+      "input, threshold, ratio, attack, release, output, numSamples,\n"
+      "                states1, states2, hidden, stream1, stream2",
+      makeLoader<NativeCL1BModel<6, 4>>() },
+
+    { "neural-piano", "NativePianoModel<64>", "../NativePianoModel.h", "neuralPiano",
+      "const float* input, const float* key, const float* velocity,\n"
+      "                     float* output, int numSamples, float* h, float* stream = nullptr",
+      "input, key, velocity, output, numSamples, h, stream",
+      makeLoader<NativePianoModel<64>>() },
+
+    // The other end of NeuralPiano's body morph
+    { "neural-piano-grand", "NativePianoModel<64>", "../NativePianoModel.h", "neuralPianoGrand",
+      "const float* input, const float* key, const float* velocity,\n"
+      "                     float* output, int numSamples, float* h, float* stream = nullptr",
+      "input, key, velocity, output, numSamples, h, stream",
+      makeLoader<NativePianoModel<64>>() },
+};
+
+std::string fileName (const std::string& path)
+{
+    auto slash = path.find_last_of ("/\\");
+    return slash == std::string::npos ? path : path.substr (slash + 1);
+}
+
+// Shortest spelling that reads back as the same float
+std::string floatLiteral (float value)
+{
+    char text[32];
+
+    for (int precision = 6; precision <= 9; ++precision)
+    {
+        std::snprintf (text, sizeof (text), "%.*g", precision, (double) value);
+
+        if (std::strtof (text, nullptr) == value)
+            break;
+    }
+
+    std::string literal (text);
+
+    if (literal.find_first_of (".e") == std::string::npos)
+        literal += ".0";
+
+    return literal + "f";
+}
+
+bool writeHeader (const Target& target, const std::string& modelPath, const std::string& outputPath)
+{
+    neural::OnnxInitializers initializers;
+
+    if (! initializers.loadFromFile (modelPath))
+    {
+        std::fprintf (stderr, "%s: %s\n", modelPath.c_str(), initializers.getLastError().c_str());
+        return false;
+    }
+
+    std::string values;
+    int numValues = 0;
+
+    auto appendArray = [&] (const float* data, int size)
+    {
+        for (int i = 0; i < size; ++i)
+            values += (i % 8 == 0 ? "\n    " : " ") + floatLiteral (data[i]) + ",";
+
+        values += "\n";
+        numValues += size;
+    };
+
+    if (! target.loadAndVisit (initializers, appendArray))
+    {
+        std::fprintf (stderr, "%s does not match %s: %s\n", modelPath.c_str(), target.name,
+                      initializers.getLastError().c_str());
+        return false;
+    }
+
+    std::string header =
+        "/*\n"
+        "  ==============================================================================\n\n"
+        "    " + fileName (outputPath) + "\n\n"
+        "    Generated by Tools/GenerateModelHeader.cpp from " + fileName (modelPath) + ".\n"
+        "    Do not edit; re-run the tool after retraining the model.\n\n"
+        "  ==============================================================================\n"
+        "*/\n\n"
+        "#pragma once\n\n"
+        "#include \"" + std::string (target.include) + "\"\n\n"
+        "namespace generated::" + target.nameSpace + "\n"
+        "{\n\n"
+        "using Model = " + target.modelType + ";\n\n"
+        "// " + std::to_string (numValues) + " values, in Model::Weights::visitArrays order\n"
+        "inline constexpr Model::Weights weights\n"
+        "{";
+
+    header += values +
+        "};\n\n"
+        "inline void process (" + std::string (target.parameters) + ")\n"
+        "{\n"
+        "    Model::run (weights, " + target.arguments + ");\n"
+        "}\n\n"
+        "} // namespace generated::" + target.nameSpace + "\n";
+
+    // Same line endings as the rest of the sources
+    std::string text;
+
+    for (auto character : header)
+        text += character == '\n' ? std::string ("\r\n") : std::string (1, character);
+
+    auto* file = std::fopen (outputPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        std::fprintf (stderr, "cannot write %s\n", outputPath.c_str());
+        return false;
+    }
+
+    std::fwrite (text.data(), 1, text.size(), file);
+    std::fclose (file);
+
+    std::printf ("%s: %d weights -> %s\n", modelPath.c_str(), numValues, outputPath.c_str());
+    return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    if (argc == 4)
+        for (auto& target : targets)
+            if (std::string (argv[1]) == target.name)
+                return writeHeader (target, argv[2], argv[3]) ? 0 : 1;
+
+    std::fprintf (stderr, "usage: GenerateModelHeader <target> <model.onnx> <output.h>\n\ntargets:");
+
+    for (auto& target : targets)
+        std::fprintf (stderr, " %s", target.name);
+
+    std::fprintf (stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+    RunNativeModel.cpp
+
+    Streams a signal through the native kernel of one of the shipped models,
+    block by block, carrying the states the way the plugins do.
+    Tools/compare_engines.py builds and drives it to check the native engine
+    against ONNX Runtime; it needs neither JUCE nor ONNX Runtime.
+
+    The mode picks the graph to follow. "stock" carries only the states the
+    exported graph takes back, as the plugins do with the shipped models.
+    "streaming" also carries the conv history and every scan row, as the
+    plugins do with models rewritten by Tools/expose_conv_history.py; it is
+    only there for the Mamba models (cl1b, neural-piano, neural-piano-grand).
+
+    The input file holds the model's per-sample inputs as raw float32, one
+    after the other: the audio, then the conditioning in the order the graph
+    takes it (tape-preamp: c, t, p; cl1b: threshold, ratio, attack, release;
+    neural-piano: k, v). The output file gets the model's raw output, before
+    the plugins' soft limiter.
+
+    Build and run from the repository root:
+
+        c++ -std=c++17 -O2 Tools/RunNativeModel.cpp -o RunNativeModel
+        ./RunNativeModel cl1b stock NeuralCL1B/Models/CL1B_nof.onnx 512 input.f32 output.f32
+
+  ==============================================================================
+*/
+
+#include "../Common/LstmFilmModel.h"
+#include "../NeuralCL1B/Source/NativeCL1BModel.h"
+#include "../NeuralPiano/Source/NativePianoModel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// The per-sample inputs, audio first, each numSamples long
+using Streams = std::vector<const float*>;
+using BlockVisitor = std::function<void (int start, int numSamples)>;
+
+struct Target
+{
+    const char* name;
+    int numStreams;
+    bool hasStreamState;
+    std::function<bool (const std::string&, const Streams&, float*, int, int, bool)> run;
+};
+
+void forEachBlock (int numSamples, int blockSize, const BlockVisitor& visit)
+{
+    for (int start = 0; start < numSamples; start += blockSize)
+        visit (start, std::min (blockSize, numSamples - start));
+}
+
+bool runTapePreamp (const std::string& modelPath, const Streams& in, float* output, int numSamples, int blockSize, bool)
+{
+    using Model = neural::TapePreampLstmModel;
+
+    Model model;
+
+    if (! model.load (modelPath, neural::tapePreampLstmWeights))
+        return false;
+
+    std::vector<float> h (Model::hiddenSize), c (Model::hiddenSize);
+
+    forEachBlock (numSamples, blockSize, [&] (int start, int length)
+    {
+        const float* conditioning[] = { in[1] + start, in[2] + start, in[3] + start };
+        model.process (in[0] + start, conditioning, output + start, length, h.data(), c.data());
+    });
+
+    return true;
+}
+
+bool runCL1B (const std::string& modelPath, const Streams& in, float* output, int numSamples, int blockSize, bool streaming)
+{
+    using Model = NativeCL1BModel<6, 4>;
+
+    auto model = std::make_unique<Model>();
+
+    if (! model->load (modelPath))
+        return false;
+
+    std::vector<float> states1 (Model::ScanBlock::scanStateSize), states2 (Model::ScanBlock::scanStateSize);
+    std::vector<float> hidden (4);
+    std::vector<float> stream1 (Model::ScanBlock::streamStateSize), stream2 (Model::ScanBlock::streamStateSize);
+
+    forEachBlock (numSamples, blockSize, [&] (int start, int length)
+    {
+        model->process (in[0] + start, in[1] + start, in[2] + start, in[3] + start, in[4] + start,
+                        output + start, length, states1.data(), states2.data(), hidden.data(),
+                        streaming ? stream1.data() : nullptr, streaming ? stream2.data() : nullptr);
+    });
+
+    return true;
+}
+
+bool runPiano (const std::string& modelPath, const Streams& in, float* output, int numSamples, int blockSize, bool streaming)
+{
+    using Model = NativePianoModel<64>;
+
+    auto model = std::make_unique<Model>();
+
+    if (! model->load (modelPath))
+        return false;
+
+    std::vector<float> h (Model::ScanBlock::scanStateSize), stream (Model::ScanBlock::streamStateSize);
+
+    forEachBlock (numSamples, blockSize, [&] (int start, int length)
+    {
+        model->process (in[0] + start, in[1] + start, in[2] + start, output + start, length,
+                        h.data(), streaming ? stream.data() : nullptr);
+    });
+
+    return true;
+}
+
+const Target targets[] =
+{
+    { "tape-preamp",        4, false, runTapePreamp },
+    { "cl1b",               5, true,  runCL1B },
+    { "neural-piano",       3, true,  runPiano },
+    { "neural-piano-grand", 3, true,  runPiano },
+};
+
+bool readFloats (const char* path, std::vector<float>& values)
+{
+    auto* file = std::fopen (path, "rb");
+
+    if (file == nullptr)
+        return false;
+
+    std::fseek (file, 0, SEEK_END);
+    values.resize ((size_t) std::ftell (file) / sizeof (float));
+    std::fseek (file, 0, SEEK_SET);
+
+    const bool complete = std::fread (values.data(), sizeof (float), values.size(), file) == values.size();
+    std::fclose (file);
+    return complete;
+}
+
+bool writeFloats (const char* path, const std::vector<float>& values)
+{
+    auto* file = std::fopen (path, "wb");
+
+    if (file == nullptr)
+        return false;
+
+    const bool complete = std::fwrite (values.data(), sizeof (float), values.size(), file) == values.size();
+    std::fclose (file);
+    return complete;
+}
+
+int run (const Target& target, bool streaming, const char* modelPath, int blockSize,
+         const char* inputPath, const char* outputPath)
+{
+    if (streaming && ! target.hasStreamState)
+    {
+        std::fprintf (stderr, "%s carries every state already, use the stock mode\n", target.name);
+        return 1;
+    }
+
+    std::vector<float> input;
+
+    if (! readFloats (inputPath, input) || input.empty() || input.size() % (size_t) target.numStreams != 0)
+    {
+        std::fprintf (stderr, "%s: expected %d float32 streams of equal length\n", inputPath, target.numStreams);
+        return 1;
+    }
+
+    const int numSamples = (int) (input.size() / (size_t) target.numStreams);
+    Streams streams;
+
+    for (int i = 0; i < target.numStreams; ++i)
+        streams.push_back (input.data() + (size_t) i * (size_t) numSamples);
+
+    std::vector<float> output ((size_t) numSamples);
+
+    if (! target.run (modelPath, streams, output.data(), numSamples, blockSize, streaming))
+    {
+        std::fprintf (stderr, "%s does not match %s\n", modelPath, target.name);
+        return 1;
+    }
+
+    if (! writeFloats (outputPath, output))
+    {
+        std::fprintf (stderr, "cannot write %s\n", outputPath);
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    const std::string mode = argc == 7 ? argv[2] : "";
+
+    if ((mode == "stock" || mode == "streaming") && std::atoi (argv[4]) > 0)
+        for (auto& target : targets)
+            if (std::string (argv[1]) == target.name)
+                return run (target, mode == "streaming", argv[3], std::atoi (argv[4]), argv[5], argv[6]);
+
+    std::fprintf (stderr, "usage: RunNativeModel <target> <stock|streaming> <model.onnx> <block size> <input.f32> <output.f32>\n\n"
+                          "targets:");
+
+    for (auto& target : targets)
+        std::fprintf (stderr, " %s", target.name);
+
+    std::fprintf (stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    SelectiveScanOpLibrary.cpp
+
+    neural::SelectiveScan (Common/SelectiveScanOp.h) as an ONNX Runtime
+    custom-op library, for loading the models Tools/fuse_selective_scan.py
+    writes outside the plugins: the Python tools pass it to
+    SessionOptions.register_custom_ops_library, and
+    convert_models_to_ort.py / build_minimal_onnxruntime.sh need it to keep
+    the node. The plugins register the same operator themselves and do not
+    ship this.
+
+    Build from the repository root, against the headers of the onnxruntime
+    the Python package matches:
+
+        c++ -std=c++17 -O2 -shared -fPIC -I<onnxruntime>/include Tools/SelectiveScanOpLibrary.cpp -o libneural_ops.so
+        python3 Tools/fuse_selective_scan.py NeuralCL1B/Models/CL1B_nof.onnx /tmp/CL1B_fused.onnx --custom-op-library ./libneural_ops.so
+
+    (-dynamiclib and libneural_ops.dylib on macOS.) The library calls the
+    runtime only through the OrtApi it is handed, so it links nothing.
+
+  ==============================================================================
+*/
+
+#define ORT_API_MANUAL_INIT
+#include "../Common/SelectiveScanOp.h"
+
+extern "C" ORT_EXPORT OrtStatus* ORT_API_CALL RegisterCustomOps (OrtSessionOptions* options, const OrtApiBase* api)
+{
+    const OrtApi* ortApi = api->GetApi (ORT_API_VERSION);
+    Ort::InitApi (ortApi);
+
+    try
+    {
+        Ort::UnownedSessionOptions (options).Add (neural::getSelectiveScanDomain());
+    }
+    catch (const Ort::Exception& e)
+    {
+        return ortApi->CreateStatus (e.GetOrtErrorCode(), e.what());
+    }
+
+    return nullptr;
+}
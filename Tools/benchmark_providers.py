@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Times one block of each model with ONNX Runtime's default CPU provider and
+with the XNNPACK execution provider in front of it, the way the plugins run
+it: one intra-op thread, sequential execution, full graph optimisation, and
+the new_* outputs fed back as the next block's states.
+
+XNNPACK may handle the small MatMul / Conv shapes in these graphs better
+than MLAS, or worse; the plugins only use it with NEURAL_ORT_XNNPACK=1, so
+check here first. For every model and block length it prints the median and
+99th percentile latency per block, and the share of a 48 kHz block's time
+that is. XNNPACK is skipped, with a note, where the installed onnxruntime
+lacks it.
+
+Usage:
+    python3 benchmark_providers.py [model.onnx ...] [--blocks 32,64,128,256,512] [--runs 2000]
+
+Without models it times the ones the plugins ship. Requires the
+`onnxruntime` and `numpy` Python packages.
+"""
+
+import argparse
+import os
+import sys
+import time
+
+import numpy as np
+
+import onnxruntime as ort
+
+
+SAMPLE_RATE = 48000
+XNNPACK = "XnnpackExecutionProvider"
+SHIPPED_MODELS = [
+    "NeuralCL1B/Models/CL1B_nof.onnx",
+    "Hybrid/Models/CL1BTapePreamp__lstm_8.onnx",
+    "NeuralPiano/Models/NeuralPiano_up.onnx",
+]
+
+
+def create_session(path, use_xnnpack):
+    options = ort.SessionOptions()
+    options.intra_op_num_threads = 1
+    options.execution_mode = ort.ExecutionMode.ORT_SEQUENTIAL
+    options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+
+    providers = [(XNNPACK, {"intra_op_num_threads": "1"})] if use_xnnpack else []
+    providers.append("CPUExecutionProvider")
+    return ort.InferenceSession(path, options, providers=providers)
+
+
+def make_feeds(session, block_size, rng):
+    # Inputs with a symbolic length take the block, the rest (states) are
+    # zeros; audio is noise and controls sit mid-range
+    feeds = {}
+
+    for index, value in enumerate(session.get_inputs()):
+        shape = [block_size if isinstance(d, str) and axis == 1 else (d if isinstance(d, int) else 1)
+                 for axis, d in enumerate(value.shape)]
+
+        if index == 0:
+            feeds[value.name] = rng.uniform(-0.5, 0.5, shape).astype(np.float32)
+        elif any(isinstance(d, str) for d in value.shape[1:2]):
+            feeds[value.name] = np.full(shape, 0.5, dtype=np.float32)
+        else:
+            feeds[value.name] = np.zeros(shape, dtype=np.float32)
+
+    return feeds
+
+
+def time_blocks(session, block_size, num_runs):
+    feeds = make_feeds(session, block_size, np.random.default_rng(0))
+    output_names = [o.name for o in session.get_outputs()]
+
+    # new_h -> h, new_states1 -> states1: the plugins take back the first
+    # rows of a state the model returns larger than it takes
+    state_of = {name: name[len("new_"):] for name in output_names if name[len("new_"):] in feeds}
+
+    def run():
+        outputs = session.run(output_names, feeds)
+
+        for name, value in zip(output_names, outputs):
+            if name in state_of:
+                state = feeds[state_of[name]]
+                feeds[state_of[name]] = value.reshape(-1)[:state.size].reshape(state.shape)
+
+    for _ in range(max(50, num_runs // 20)):
+        run()
+
+    latencies = np.empty(num_runs)
+
+    for i in range(num_runs):
+        start = time.perf_counter()
+        run()
+        latencies[i] = time.perf_counter() - start
+
+    return np.median(latencies), np.percentile(latencies, 99)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("models", nargs="*")
+    parser.add_argument("--blocks", default="32,64,128,256,512")
+    parser.add_argument("--runs", type=int, default=2000)
+    args = parser.parse_args()
+
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    models = args.models or [os.path.join(root, m) for m in SHIPPED_MODELS]
+    block_sizes = [int(b) for b in args.blocks.split(",")]
+
+    has_xnnpack = XNNPACK in ort.get_available_providers()
+    print("onnxruntime %s, providers: %s" % (ort.__version__, ", ".join(ort.get_available_providers())))
+
+    if not has_xnnpack:
+        print("XNNPACK is not in this build: timing the CPU provider only "
+              "(the plugins fall back to it the same way)")
+
+    for path in models:
+        print("\n%s" % os.path.relpath(path))
+        print("  %6s  %-8s %12s %12s %9s" % ("block", "provider", "median us", "p99 us", "% of RT"))
+
+        for block_size in block_sizes:
+            medians = {}
+
+            for use_xnnpack in ([False, True] if has_xnnpack else [False]):
+                name = "XNNPACK" if use_xnnpack else "CPU"
+                median, p99 = time_blocks(create_session(path, use_xnnpack), block_size, args.runs)
+                medians[name] = median
+                print("  %6d  %-8s %12.1f %12.1f %8.2f%%"
+                      % (block_size, name, median * 1e6, p99 * 1e6, 100 * median * SAMPLE_RATE / block_size))
+
+            if len(medians) == 2:
+                print("  %6s  XNNPACK / CPU median: %.2fx" % ("", medians["XNNPACK"] / medians["CPU"]))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# Builds a reduced onnxruntime for the plugins: a minimal build, which only
+# reads the pre-optimised .ort models, with kernels for nothing but the
+# operators in Tools/required_operators.config (written by
+# convert_models_to_ort.py). It is a fraction of the full dylib's size, so
+# the bundles are smaller and hosts scan them faster.
+#
+# The dylib and headers replace those in each project's
+# ExternalLibs/onnxruntime-osx-universal2-<version>; the full build is moved
+# to ExternalLibs/onnxruntime-osx-universal2-<version>-full the first time,
+# and moving it back restores it. The .jucer projects need no change.
+#
+# Usage:
+#     sh build_minimal_onnxruntime.sh <onnxruntime source checkout> [--xnnpack]
+#
+# Check out the version the .jucer projects link (v1.19.2), and convert the
+# models first. --xnnpack keeps the XNNPACK execution provider, which needs
+# the extended minimal build. Custom operators stay enabled, for models
+# with fused selective scans (Tools/fuse_selective_scan.py).
+
+set -e
+
+ORT_VERSION=1.19.2
+TOOLS_DIR=$(cd "$(dirname "$0")" && pwd)
+ROOT_DIR=$(dirname "$TOOLS_DIR")
+CONFIG="$TOOLS_DIR/required_operators.config"
+PROJECTS="Hybrid NeuralCL1B NeuralPiano"
+
+if [ -z "$1" ] || [ ! -f "$1/build.sh" ]; then
+    echo "usage: $0 <onnxruntime source checkout> [--xnnpack]"
+    exit 1
+fi
+
+if [ ! -f "$CONFIG" ]; then
+    echo "$CONFIG is missing: run convert_models_to_ort.py first"
+    exit 1
+fi
+
+ORT_SOURCE=$(cd "$1" && pwd)
+BUILD_DIR="$ORT_SOURCE/build/neural-minimal"
+MINIMAL="--minimal_build custom_ops"
+EXTRA=
+
+if [ "$2" = "--xnnpack" ]; then
+    MINIMAL="--minimal_build extended custom_ops"
+    EXTRA=--use_xnnpack
+fi
+
+# Contrib operators stay: the optimised graphs use the fused BiasGelu and QuickGelu
+"$ORT_SOURCE/build.sh" --config MinSizeRel --build_dir "$BUILD_DIR" --build_shared_lib --parallel --skip_tests \
+    $MINIMAL --include_ops_by_config "$CONFIG" --disable_ml_ops $EXTRA \
+    --apple_deploy_target 12.0 --cmake_extra_defines CMAKE_OSX_ARCHITECTURES="arm64;x86_64"
+
+DYLIB="$BUILD_DIR/MinSizeRel/libonnxruntime.$ORT_VERSION.dylib"
+
+if [ ! -f "$DYLIB" ]; then
+    echo "$DYLIB was not built: is the checkout at v$ORT_VERSION?"
+    exit 1
+fi
+
+for project in $PROJECTS; do
+    target="$ROOT_DIR/$project/ExternalLibs/onnxruntime-osx-universal2-$ORT_VERSION"
+
+    if [ -d "$target" ] && [ ! -d "$target-full" ]; then
+        mv "$target" "$target-full"
+    fi
+
+    mkdir -p "$target/lib" "$target/include"
+    cp "$DYLIB" "$target/lib/"
+    ln -sf "libonnxruntime.$ORT_VERSION.dylib" "$target/lib/libonnxruntime.dylib"
+    cp "$ORT_SOURCE"/include/onnxruntime/core/session/*.h "$target/include/"
+    echo "$project: minimal onnxruntime in $target"
+done
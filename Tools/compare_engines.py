@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+Regression check of the two inference engines: streams a fixed reference
+signal through each plugin's ONNX Runtime path and native path at several
+block sizes, and compares both against reference audio committed in
+Tools/reference.
+
+Both engines run the same graph, in one of two modes:
+
+    stock       the shipped .onnx file, with only the states it takes back
+                carried between blocks
+    streaming   the same model rewritten by expose_conv_history.py, which
+                also carries the conv history and every scan row (Mamba
+                models only)
+
+The ONNX Runtime path runs the graph the way the plugins do: one intra-op
+thread, one call per block, and the new_* outputs fed back as the next
+block's states (the first rows of a state the model returns larger than it
+takes). The native path is Tools/RunNativeModel.cpp in the same mode, which
+the script compiles first unless --runner names a built one. Both compare
+the model's raw output, before the plugins' soft limiter. The reference
+audio is the ONNX Runtime output at each block size, so the check catches
+changes to either engine, and how far native sits from the graph.
+
+The script prints the largest absolute difference from the reference for
+every model, block size and engine, and exits with status 1 when one of them
+exceeds the tolerance: 1e-4 by default, 80 dB below full scale.
+--write-reference regenerates the reference audio from the current ONNX
+Runtime path instead; commit the files it writes.
+
+Usage:
+    python3 compare_engines.py [--models cl1b,tape-preamp] [--modes stock,streaming]
+        [--tolerance 1e-4] [--runner ./RunNativeModel] [--write-reference]
+
+Run from anywhere; it finds the models relative to itself. Requires the
+packages in Tools/requirements.txt and, without --runner, a C++17 compiler
+($CXX, or c++).
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+import numpy as np
+
+import onnx
+import onnxruntime as ort
+
+from expose_conv_history import carry_scan_rows, expose_conv_history
+
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+REFERENCE_DIR = os.path.join(ROOT, "Tools", "reference")
+SAMPLE_RATE = 48000
+NUM_SAMPLES = 8192
+BLOCK_SIZES = [1, 64, 512]
+MODES = ["stock", "streaming"]
+
+# RunNativeModel target -> the model file the plugin loads
+MODELS = {
+    "tape-preamp": "Hybrid/Models/CL1BTapePreamp__lstm_8.onnx",
+    "cl1b": "NeuralCL1B/Models/CL1B_nof.onnx",
+    "neural-piano": "NeuralPiano/Models/NeuralPiano_up.onnx",
+    "neural-piano-grand": "NeuralPiano/Models/NeuralPiano_grand.onnx",
+}
+
+
+def load_graph(path, mode):
+    """The serialised graph a mode runs, or None when the model has nothing
+    more to carry in that mode."""
+    model = onnx.load(path)
+
+    if mode == "streaming" and expose_conv_history(model) + carry_scan_rows(model) == 0:
+        return None
+
+    return model.SerializeToString()
+
+
+def create_session(graph):
+    options = ort.SessionOptions()
+    options.intra_op_num_threads = 1
+    options.execution_mode = ort.ExecutionMode.ORT_SEQUENTIAL
+    options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+    return ort.InferenceSession(graph, options, providers=["CPUExecutionProvider"])
+
+
+def num_streams(session):
+    return len([value for value in session.get_inputs() if isinstance(value.shape[1], str)])
+
+
+def reference_streams(num_streams):
+    """The audio and the conditioning, in graph order. Formulas rather than a
+    random generator, so the signal does not depend on the numpy version."""
+    n = np.arange(NUM_SAMPLES)
+    t = n / SAMPLE_RATE
+
+    # Tones whose level steps every 1024 samples, for the compressors' attack and release
+    level = np.array([0.05, 0.6, 0.2, 0.9])[(n // 1024) % 4]
+    audio = level * (0.6 * np.sin(2 * np.pi * 110 * t) + 0.3 * np.sin(2 * np.pi * 1375 * t)
+                     + 0.1 * np.sin(2 * np.pi * 5400 * t))
+
+    # Each control sweeps its 0..1 range at a rate of its own
+    controls = [0.5 + 0.45 * np.sin(2 * np.pi * (3 + 2 * i) * t + i) for i in range(num_streams - 1)]
+    return np.stack([audio] + controls).astype(np.float32)
+
+
+def run_onnxruntime(session, streams, block_size):
+    inputs = session.get_inputs()
+    per_sample = [value.name for value in inputs if isinstance(value.shape[1], str)]
+    states = {value.name: np.zeros([d if isinstance(d, int) else 1 for d in value.shape], dtype=np.float32)
+              for value in inputs if value.name not in per_sample}
+    output_names = [value.name for value in session.get_outputs()]
+    output = []
+
+    for start in range(0, NUM_SAMPLES, block_size):
+        feeds = dict(states)
+        feeds.update({name: stream[start:start + block_size].reshape(1, -1, 1)
+                      for name, stream in zip(per_sample, streams)})
+        values = dict(zip(output_names, session.run(output_names, feeds)))
+        output.append(values[output_names[0]].reshape(-1))
+
+        for name, state in states.items():
+            returned = values["new_" + name]
+            states[name] = returned[tuple(slice(0, d) for d in state.shape)].astype(np.float32)
+
+    return np.concatenate(output)
+
+
+def build_runner(directory):
+    runner = os.path.join(directory, "RunNativeModel")
+    compiler = os.environ.get("CXX", "c++")
+    subprocess.run([compiler, "-std=c++17", "-O2", os.path.join(ROOT, "Tools", "RunNativeModel.cpp"), "-o", runner],
+                   check=True)
+    return runner
+
+
+def run_native(runner, target, mode, model_path, streams, block_size, directory):
+    input_path = os.path.join(directory, "input.f32")
+    output_path = os.path.join(directory, "output.f32")
+    streams.tofile(input_path)
+    subprocess.run([runner, target, mode, model_path, str(block_size), input_path, output_path], check=True)
+    return np.fromfile(output_path, dtype=np.float32)
+
+
+def reference_path(target):
+    return os.path.join(REFERENCE_DIR, target + ".npz")
+
+
+def reference_key(mode, block_size):
+    return "%s_block_%d" % (mode, block_size)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--models", default=",".join(MODELS))
+    parser.add_argument("--modes", default=",".join(MODES))
+    parser.add_argument("--tolerance", type=float, default=1e-4)
+    parser.add_argument("--runner")
+    parser.add_argument("--write-reference", action="store_true")
+    args = parser.parse_args()
+
+    targets = args.models.split(",")
+    modes = args.modes.split(",")
+
+    for target in targets:
+        if target not in MODELS:
+            parser.error("unknown model %s (have: %s)" % (target, ", ".join(MODELS)))
+
+    for mode in modes:
+        if mode not in MODES:
+            parser.error("unknown mode %s (have: %s)" % (mode, ", ".join(MODES)))
+
+    print("onnxruntime %s, tolerance %g" % (ort.__version__, args.tolerance))
+
+    if args.write_reference:
+        os.makedirs(REFERENCE_DIR, exist_ok=True)
+
+        # Every mode is written, whatever --modes says, so no file loses one
+        for target in targets:
+            outputs = {}
+
+            for mode in MODES:
+                graph = load_graph(os.path.join(ROOT, MODELS[target]), mode)
+
+                if graph is not None:
+                    session = create_session(graph)
+                    streams = reference_streams(num_streams(session))
+                    outputs.update({reference_key(mode, b): run_onnxruntime(session, streams, b) for b in BLOCK_SIZES})
+
+            np.savez_compressed(reference_path(target), onnxruntime_version=ort.__version__, **outputs)
+            print("%s -> %s" % (target, os.path.relpath(reference_path(target))))
+
+        return 0
+
+    failures = 0
+
+    with tempfile.TemporaryDirectory() as directory:
+        runner = args.runner or build_runner(directory)
+
+        for target in targets:
+            model_path = os.path.join(ROOT, MODELS[target])
+            reference = np.load(reference_path(target))
+
+            print("\n%s (%s, reference from onnxruntime %s)"
+                  % (target, MODELS[target], reference["onnxruntime_version"]))
+            print("  %-10s %6s %14s %14s" % ("mode", "block", "onnxruntime", "native"))
+
+            for mode in modes:
+                graph = load_graph(model_path, mode)
+
+                if graph is None:
+                    print("  %-10s (the model carries every state already)" % mode)
+                    continue
+
+                session = create_session(graph)
+                streams = reference_streams(num_streams(session))
+
+                for block_size in BLOCK_SIZES:
+                    expected = reference[reference_key(mode, block_size)]
+                    drift = [float(np.max(np.abs(output - expected))) for output in
+                             (run_onnxruntime(session, streams, block_size),
+                              run_native(runner, target, mode, model_path, streams, block_size, directory))]
+                    failed = [d > args.tolerance for d in drift]
+                    failures += sum(failed)
+
+                    print("  %-10s %6d %13.3g%s %13.3g%s" % (mode, block_size, drift[0], "!" if failed[0] else " ",
+                                                             drift[1], "!" if failed[1] else " "))
+
+    print("\n%s" % ("%d result(s) over the tolerance, marked !" % failures if failures else "all within the tolerance"))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Converts the models the plugins ship to ONNX Runtime's pre-optimised .ort
+format, and lists the operators they use for a reduced onnxruntime build.
+
+Every plugin instance that opens a .onnx file has ONNX Runtime parse it and
+run graph optimisation first. A .ort file holds the graph already optimised
+and in ONNX Runtime's own serialisation, so creating a session from it is a
+read. neural::OrtSessionCache loads X.ort instead of X.onnx when both sit in
+the same folder, and the Xcode post-build steps copy the .ort files into
+the bundle when they exist. The native kernels keep reading their weights
+from the .onnx files.
+
+The .ort files are written next to the models:
+
+    NeuralCL1B/Models/CL1B_nof.ort
+    Hybrid/Models/CL1BTapePreamp__lstm_8.ort
+    NeuralPiano/Models/NeuralPiano_up.ort, NeuralPiano_grand.ort
+
+and the operators all of them need to Tools/required_operators.config, the
+input of Tools/build_minimal_onnxruntime.sh. The optimisations baked in
+leave out the NCHWc layout, so a file runs on any CPU, ARM included. Each
+converted model is checked against the original on random input; the
+largest difference is printed.
+
+Run it with the onnxruntime Python package of the version the plugins link
+(see ORT_VERSION), since an older runtime may not read what a newer one
+writes:
+
+    pip install onnxruntime==1.19.2
+    python3 convert_models_to_ort.py [--custom-op-library libneural_ops.so]
+
+Models with fused selective scans (Tools/fuse_selective_scan.py) need the
+operator built as a library (Tools/SelectiveScanOpLibrary.cpp). Requires
+the `onnxruntime` and `numpy` Python packages.
+"""
+
+import argparse
+import os
+import pathlib
+import shutil
+import sys
+import tempfile
+
+import numpy as np
+
+import onnxruntime as ort
+from onnxruntime.tools.convert_onnx_models_to_ort import OptimizationStyle, convert_onnx_models_to_ort
+
+
+ORT_VERSION = "1.19.2"     # the onnxruntime the .jucer projects link
+SHIPPED_MODELS = [
+    "NeuralCL1B/Models/CL1B_nof.onnx",
+    "Hybrid/Models/CL1BTapePreamp__lstm_8.onnx",
+    "NeuralPiano/Models/NeuralPiano_up.onnx",
+    "NeuralPiano/Models/NeuralPiano_grand.onnx",
+]
+CONFIG_NAME = "required_operators.config"
+
+
+def random_feeds(session, block_size=256):
+    rng = np.random.default_rng(0)
+    feeds = {}
+
+    for value in session.get_inputs():
+        shape = [d if isinstance(d, int) else (block_size if axis == 1 else 1) for axis, d in enumerate(value.shape)]
+        feeds[value.name] = rng.uniform(-0.5, 0.5, shape).astype(np.float32)
+
+    return feeds
+
+
+def largest_difference(onnx_path, ort_path, custom_op_library):
+    options = ort.SessionOptions()
+
+    if custom_op_library:
+        options.register_custom_ops_library(custom_op_library)
+
+    reference = ort.InferenceSession(str(onnx_path), options, providers=["CPUExecutionProvider"])
+    converted = ort.InferenceSession(str(ort_path), options, providers=["CPUExecutionProvider"])
+    feeds = random_feeds(reference)
+
+    return max(float(np.max(np.abs(a - b))) if a.size else 0.0
+               for a, b in zip(reference.run(None, feeds), converted.run(None, feeds)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--custom-op-library")
+    args = parser.parse_args()
+
+    library = os.path.abspath(args.custom_op_library) if args.custom_op_library else None
+    root = pathlib.Path(__file__).resolve().parent.parent
+    models = [root / m for m in SHIPPED_MODELS]
+
+    if ort.__version__ != ORT_VERSION:
+        print("warning: converting with onnxruntime %s, the plugins link %s" % (ort.__version__, ORT_VERSION))
+
+    with tempfile.TemporaryDirectory() as work:
+        work = pathlib.Path(work)
+
+        for model in models:
+            shutil.copy(model, work / model.name)
+
+        convert_onnx_models_to_ort(work, output_dir=work / "ort", optimization_styles=[OptimizationStyle.Fixed],
+                                   custom_op_library_path=pathlib.Path(library) if library else None)
+
+        for model in models:
+            converted = model.with_suffix(".ort")
+            shutil.copy(work / "ort" / converted.name, converted)
+            print("%-45s %7d -> %7d bytes, largest difference %g"
+                  % (os.path.relpath(converted, root), model.stat().st_size, converted.stat().st_size,
+                     largest_difference(model, converted, library)))
+
+        # Keep the operator list, with the repository's paths in its header
+        lines = (work / "ort" / CONFIG_NAME).read_text().splitlines()
+        header = ["# Generated by Tools/convert_models_to_ort.py (onnxruntime %s) from:" % ort.__version__]
+        header += ["# - %s" % m for m in SHIPPED_MODELS]
+        operators = [line for line in lines if line and not line.startswith("#")]
+        (root / "Tools" / CONFIG_NAME).write_text("\n".join(header + operators) + "\n")
+
+    print("operators for the reduced build: Tools/%s" % CONFIG_NAME)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Rewrites an exported Mamba/S6 model so that the causal convolutions stream.
+
+The PyTorch export zero-pads every depthwise Conv1d on the left with a Pad
+node, so each ONNX Runtime call starts the convolution from silence and the
+output depends on the host block size. This script replaces each such Pad with
+a Concat of a new graph input (the previous call's last kernel_size - 1 conv
+inputs) and adds a matching graph output, so the taps' history can be carried
+between calls exactly like the recurrent states:
+
+    conv_history1 [1, channels, kernel_size - 1]  ->  new_conv_history1
+    conv_history2 ...                              ->  new_conv_history2
+
+Convolutions with a kernel size of 1 (the NeuralPiano models) have no history
+and are left untouched.
+
+The scan states need the same treatment. The export takes a [1, 1, N] state
+and broadcasts it across the inner channels, but returns all of them,
+[1, inner, N]. A caller can only feed back the first row, so the other
+channels restart from the first channel's state on every call. The script
+widens each such input to the shape of its new_* output. The broadcast in
+the graph then becomes a plain read:
+
+    states1 [1, 1, 6]   ->  [1, 4, 6]       (CL1B)
+    h       [1, 1, 64]  ->  [1, 2, 64]      (NeuralPiano)
+
+The plugins detect the extra inputs by name and the wider states by shape,
+so a rewritten model is a drop-in replacement for the original file. If
+onnxruntime is installed, the script also streams random input through the
+rewritten model in blocks of 1 and of 16 samples and prints the largest
+difference between the two. The scan's 1e-12 guard still makes the longer
+blocks drift a little (see SelectiveScanBlock in Common/NeuralLayers.h).
+
+Usage:
+    python3 expose_conv_history.py ../NeuralCL1B/Models/CL1B_nof.onnx [output.onnx]
+
+Requires the `onnx` Python package.
+"""
+
+import sys
+
+import onnx
+from onnx import TensorProto, helper, numpy_helper, shape_inference
+
+import numpy as np
+
+
+def find_consumers(graph, name):
+    return [node for node in graph.node if name in node.input]
+
+
+def attribute(node, name, default=None):
+    for attr in node.attribute:
+        if attr.name == name:
+            return helper.get_attribute_value(attr)
+    return default
+
+
+def prune_unused_nodes(graph):
+    """Drops the nodes that only fed the removed Pad (its pads computation)."""
+    needed = {output.name for output in graph.output}
+    kept = []
+
+    for node in reversed(graph.node):
+        if any(output in needed for output in node.output):
+            kept.append(node)
+            needed.update(name for name in node.input if name)
+
+    del graph.node[:]
+    graph.node.extend(reversed(kept))
+
+
+def expose_conv_history(model):
+    graph = model.graph
+    initializers = {init.name: init for init in graph.initializer}
+    exposed = 0
+
+    for pad in [node for node in graph.node if node.op_type == "Pad"]:
+        consumers = find_consumers(graph, pad.output[0])
+
+        if len(consumers) != 1 or consumers[0].op_type != "Conv":
+            continue
+
+        conv = consumers[0]
+        weight = numpy_helper.to_array(initializers[conv.input[1]])
+        channels, kernel_size = weight.shape[0], weight.shape[-1]
+
+        if kernel_size <= 1 or attribute(conv, "group", 1) != channels:
+            continue
+
+        exposed += 1
+        history_in = "conv_history%d" % exposed
+        history_out = "new_conv_history%d" % exposed
+        prefix = "/conv_history%d/" % exposed
+
+        # [history | block] has exactly the left context the zero padding stood in for
+        concat = helper.make_node("Concat", [history_in, pad.input[0]], [pad.output[0]],
+                                  name=prefix + "Concat", axis=2)
+
+        # The last kernel_size - 1 conv inputs become the next call's history
+        starts = numpy_helper.from_array(np.array([1 - kernel_size], dtype=np.int64), prefix + "starts")
+        ends = numpy_helper.from_array(np.array([np.iinfo(np.int64).max], dtype=np.int64), prefix + "ends")
+        axes = numpy_helper.from_array(np.array([2], dtype=np.int64), prefix + "axes")
+        graph.initializer.extend([starts, ends, axes])
+
+        tail = helper.make_node("Slice", [pad.output[0], starts.name, ends.name, axes.name], [history_out],
+                                name=prefix + "Slice")
+
+        index = list(graph.node).index(pad)
+        graph.node.remove(pad)
+        graph.node.insert(index, concat)
+        graph.node.insert(index + 1, tail)
+
+        shape = [1, channels, kernel_size - 1]
+        graph.input.append(helper.make_tensor_value_info(history_in, TensorProto.FLOAT, shape))
+        graph.output.append(helper.make_tensor_value_info(history_out, TensorProto.FLOAT, shape))
+
+    prune_unused_nodes(graph)
+    return exposed
+
+
+def carry_scan_rows(model):
+    """Widens each [1, 1, N] state input whose new_* output is [1, rows, N]."""
+    outputs = {value.name: value for value in shape_inference.infer_shapes(model).graph.output}
+    widened = 0
+
+    for value in model.graph.input:
+        returned = outputs.get("new_" + value.name)
+
+        if returned is None:
+            continue
+
+        dims = value.type.tensor_type.shape.dim
+        returned_dims = returned.type.tensor_type.shape.dim
+
+        if len(dims) != 3 or len(returned_dims) != 3 or dims[2].dim_value != returned_dims[2].dim_value:
+            continue
+
+        if dims[1].dim_value == 1 and returned_dims[1].dim_value > 1:
+            dims[1].dim_value = returned_dims[1].dim_value
+            widened += 1
+
+    return widened
+
+
+def compare_block_sizes(path, num_samples=256):
+    try:
+        import onnxruntime
+    except ImportError:
+        print("onnxruntime not installed, skipping the block size check")
+        return
+
+    session = onnxruntime.InferenceSession(path, providers=["CPUExecutionProvider"])
+    rng = np.random.default_rng(4)
+    streamed = [value for value in session.get_inputs() if isinstance(value.shape[1], str)]
+    signals = {value.name: rng.uniform(-0.5, 0.5, (1, num_samples, 1)).astype(np.float32) for value in streamed}
+    outputs = [value.name for value in session.get_outputs()]
+
+    def stream(block_size):
+        states = {value.name: np.zeros(value.shape, dtype=np.float32)
+                  for value in session.get_inputs() if value not in streamed}
+        result = []
+
+        for start in range(0, num_samples, block_size):
+            feeds = dict(states)
+            feeds.update({name: signal[:, start:start + block_size] for name, signal in signals.items()})
+            values = dict(zip(outputs, session.run(outputs, feeds)))
+            result.append(values[outputs[0]])
+            states = {name: values["new_" + name].reshape(state.shape) for name, state in states.items()}
+
+        return np.concatenate(result, axis=1)
+
+    print("blocks of 1 against blocks of 16 samples: max difference %.3g" % float(np.max(np.abs(stream(1) - stream(16)))))
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print(__doc__)
+        return 1
+
+    source = sys.argv[1]
+    destination = sys.argv[2] if len(sys.argv) == 3 else source
+
+    model = onnx.load(source)
+    exposed = expose_conv_history(model)
+    widened = carry_scan_rows(model)
+
+    if exposed == 0 and widened == 0:
+        print("%s: no causal convolution with history or broadcast scan state found, nothing to do" % source)
+        return 0
+
+    onnx.checker.check_model(model)
+    onnx.save(model, destination)
+    print("%s: exposed %d conv history input(s), widened %d scan state(s) -> %s"
+          % (source, exposed, widened, destination))
+
+    compare_block_sizes(destination)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,377 @@
+#!/usr/bin/env python3
+"""
+Replaces the selective scan of each Mamba/S6 layer in an exported model with
+one neural::SelectiveScan node (Common/SelectiveScanOp.h).
+
+The PyTorch export writes the scan in parallel form, about thirty nodes per
+layer that each produce a [batch, T, inner, state] tensor:
+
+    dt = Softplus(delta)
+    dA = dt * A                 (Unsqueeze, Mul)
+    dBx = dt * x * B            (Mul, Unsqueeze, Mul)
+    S = CumSum(Pad(Slice(dA)))  exclusive running sum of the decays
+    h = CumSum(dBx / (Exp(S) + eps)) * Exp(S) + Exp(CumSum(dA)) * h0
+    new_h = Gather(h, -1, axis 1)
+    y = ReduceSum(h * C, -1)
+
+The script matches that pattern from the Gather of the last state back,
+wires the six tensors it starts from (delta before the softplus, A, x, B, C
+and h0) into a SelectiveScan node that writes y and new_h under their
+original names, and drops every node that only fed the old subgraph. The
+skip term (x * D), the gates and the projections stay ONNX nodes. The
+weights keep their names, so the native path still loads from the file.
+
+The operator advances the same sums one step at a time, like the native
+engine's SelectiveScanBlock, 1e-12 guard included, so the fused model
+follows the nodes even where the guard makes them drift from the exact
+scan (a few samples in for the piano's fastest states). Each match is
+checked in NumPy on random input to the original model, with the largest
+differences printed: the parallel form, from the six tensors, against what
+the nodes wrote (is the match right?), the step-by-step sums against the
+parallel form (is the operator?), and the nodes against the exact scan
+(how far the guard has taken them). Given the operator built as a library
+(Tools/SelectiveScanOpLibrary.cpp), the rewritten model is run against the
+original as well.
+
+Usage:
+    python3 fuse_selective_scan.py ../NeuralPiano/Models/NeuralPiano_up.onnx [output.onnx]
+        [--custom-op-library libneural_ops.so]
+
+Requires the `onnx` Python package, and onnxruntime for the checks.
+"""
+
+import argparse
+import sys
+
+import onnx
+from onnx import helper, numpy_helper
+
+import numpy as np
+
+
+DOMAIN = "neural"
+OP_TYPE = "SelectiveScan"
+CHECK_BLOCK_SIZE = 64
+BATCH_AXIS = "batch"
+GUARD = 1e-12
+
+
+def attribute(node, name, default=None):
+    for attr in node.attribute:
+        if attr.name == name:
+            return helper.get_attribute_value(attr)
+    return default
+
+
+def prune_unused_nodes(graph):
+    """Drops the nodes that only fed the replaced subgraphs."""
+    needed = {output.name for output in graph.output}
+    kept = []
+
+    for node in reversed(graph.node):
+        if any(output in needed for output in node.output):
+            kept.append(node)
+            needed.update(name for name in node.input if name)
+
+    del graph.node[:]
+    graph.node.extend(reversed(kept))
+
+
+class Graph:
+    def __init__(self, graph):
+        self.graph = graph
+        self.producers = {output: node for node in graph.node for output in node.output}
+        self.constants = {init.name: numpy_helper.to_array(init) for init in graph.initializer}
+
+        for node in graph.node:
+            if node.op_type == "Constant" and attribute(node, "value") is not None:
+                self.constants[node.output[0]] = numpy_helper.to_array(attribute(node, "value"))
+
+    def consumers(self, name):
+        return [node for node in self.graph.node if name in node.input]
+
+    def node(self, name, op_type):
+        node = self.producers.get(name)
+
+        if node is None or node.op_type != op_type:
+            raise LookupError("%s is not the output of a %s" % (name, op_type))
+
+        return node
+
+    def axes(self, node):
+        # An attribute up to opset 12, an input after that
+        axes = attribute(node, "axes")
+
+        if axes is None and len(node.input) > 1:
+            axes = self.constants[node.input[1]].tolist()
+
+        return list(axes)
+
+    def unsqueezed(self, name, axes):
+        node = self.node(name, "Unsqueeze")
+
+        if self.axes(node) != axes:
+            raise LookupError("%s unsqueezes %s, not %s" % (node.name, self.axes(node), axes))
+
+        return node.input[0]
+
+    def other_input(self, node, name):
+        """The input of a binary node that is not name."""
+        if name not in node.input[:2]:
+            raise LookupError("%s does not read %s" % (node.name, name))
+
+        return node.input[1] if node.input[0] == name else node.input[0]
+
+    def either(self, node, match):
+        """Applies match to the node's two inputs in either order."""
+        for first, second in ((0, 1), (1, 0)):
+            try:
+                return match(node.input[first], node.input[second])
+            except LookupError:
+                pass
+
+        raise LookupError("%s does not match" % node.name)
+
+
+def match_scan(g, gather):
+    """The tensors the scan ending in this Gather starts from, or LookupError."""
+    if attribute(gather, "axis", 0) != 1 or g.constants.get(gather.input[1], np.array(0)).tolist() not in (-1, [-1]):
+        raise LookupError("not the last step")
+
+    state = g.node(gather.input[0], "Add")
+
+    def decays(name):
+        # dt * A, with dt the softplus output
+        mul = g.node(name, "Mul")
+        return g.either(mul, lambda dt, a: (g.node(g.unsqueezed(dt, [-1]), "Softplus"),
+                                            g.unsqueezed(g.unsqueezed(a, [0]), [0])))
+
+    def from_start(exp_sum, h0):
+        # Exp(CumSum(dA)) * h0
+        cumsum = g.node(g.node(exp_sum, "Exp").input[0], "CumSum")
+        return cumsum.input[0], g.unsqueezed(h0, [1])
+
+    def from_inputs(weighted, exp_exclusive):
+        # CumSum(dBx / (Exp(S) + eps)) * Exp(S)
+        div = g.node(g.node(weighted, "CumSum").input[0], "Div")
+        g.other_input(g.node(div.input[1], "Add"), exp_exclusive)
+        pad = g.node(g.node(g.node(exp_exclusive, "Exp").input[0], "CumSum").input[0], "Pad")
+        return div.input[0], g.node(pad.input[0], "Slice").input[0]
+
+    def halves(first, second):
+        return g.either(g.node(first, "Mul"), from_inputs), g.either(g.node(second, "Mul"), from_start)
+
+    (inputs_term, sliced_decays), (decays_name, h0) = g.either(state, halves)
+
+    if sliced_decays != decays_name:
+        raise LookupError("the two sums run over different decays")
+
+    softplus, a = decays(decays_name)
+
+    # dt * x * B
+    def inputs(dtx, b):
+        mul2 = g.node(g.unsqueezed(dtx, [-1]), "Mul")
+        return g.other_input(mul2, softplus.output[0]), g.unsqueezed(b, [-2])
+
+    x, b = g.either(g.node(inputs_term, "Mul"), inputs)
+
+    # y = ReduceSum(h * C), the only other reader of the state
+    readers = [node for node in g.consumers(state.output[0]) if node is not gather]
+
+    if len(readers) != 1 or readers[0].op_type != "Mul":
+        raise LookupError("the state has other readers")
+
+    c = g.unsqueezed(g.other_input(readers[0], state.output[0]), [-2])
+    reduce = g.consumers(readers[0].output[0])
+
+    if len(reduce) != 1 or reduce[0].op_type != "ReduceSum" or g.axes(reduce[0]) != [-1] \
+            or attribute(reduce[0], "keepdims", 1) != 0:
+        raise LookupError("no readout")
+
+    return {
+        "inputs": [softplus.input[0], a, x, b, c, h0],
+        "outputs": [reduce[0].output[0], gather.output[0]],
+        "replaced": [gather, reduce[0]],
+        "name": state.name.rsplit("/", 1)[0] + "/SelectiveScan",
+    }
+
+
+def find_scans(model):
+    g = Graph(model.graph)
+    scans = []
+
+    for gather in [node for node in model.graph.node if node.op_type == "Gather"]:
+        try:
+            scans.append(match_scan(g, gather))
+        except (LookupError, KeyError):
+            pass
+
+    return scans
+
+
+def fuse(model, scans):
+    graph = model.graph
+
+    for scan in scans:
+        index = min(list(graph.node).index(node) for node in scan["replaced"])
+
+        for node in scan["replaced"]:
+            graph.node.remove(node)
+
+        graph.node.insert(index, helper.make_node(OP_TYPE, scan["inputs"], scan["outputs"],
+                                                  name=scan["name"], domain=DOMAIN))
+
+    prune_unused_nodes(graph)
+
+    produced = {output for node in graph.node for output in node.output}
+    kept = [value for value in graph.value_info if value.name in produced]
+    del graph.value_info[:]
+    graph.value_info.extend(kept)
+
+    if not any(opset.domain == DOMAIN for opset in model.opset_import):
+        model.opset_import.append(helper.make_opsetid(DOMAIN, 1))
+
+
+def softplus(x):
+    return np.logaddexp(0.0, x)
+
+
+def recurrent_scan(delta, a, x, b, c, h0):
+    """What SelectiveScanKernel::scan computes, one step at a time."""
+    batch, length, inner = delta.shape
+    start = np.broadcast_to(h0, (batch, inner, a.shape[1])).astype(np.float64)
+    log_decay = np.zeros_like(start)
+    guarded_sum = np.zeros_like(start)
+    h = start
+    y = np.zeros((batch, length, inner))
+
+    for t in range(length):
+        dt = softplus(delta[:, t, :].astype(np.float64))[:, :, None]
+
+        if t == 0:
+            start = np.exp(dt * a[None]) * start
+        else:
+            log_decay = log_decay + dt * a[None]
+
+        decay = np.exp(log_decay)
+        guarded_sum = guarded_sum + dt * x[:, t, :, None] * b[:, t, None, :] / (decay + GUARD)
+        h = decay * guarded_sum + decay * start
+        y[:, t] = np.sum(h * c[:, t, None, :], axis=-1)
+
+    return y, h
+
+
+def parallel_scan(delta, a, x, b, c, h0, guarded):
+    """The exported nodes' formula; without the guard, exact in log space."""
+    dt = softplus(delta.astype(np.float64))[..., None]
+    decays = dt * a[None, None]
+    inputs = dt * x[..., None] * b[:, :, None, :]
+    start = np.exp(np.cumsum(decays, axis=1)) * h0[:, None]
+
+    if guarded:
+        exclusive = np.pad(np.cumsum(decays[:, 1:], axis=1), ((0, 0), (1, 0), (0, 0), (0, 0)))
+        h = np.cumsum(inputs / (np.exp(exclusive) + GUARD), axis=1) * np.exp(exclusive) + start
+    else:
+        # h[t] = sum over s <= t of exp(sum of decays[s + 1 .. t]) * inputs[s]
+        total = np.cumsum(decays, axis=1)
+        spans = total[:, :, None] - total[:, None, :]
+        steps = np.arange(delta.shape[1])
+        spans[:, steps[:, None] < steps[None, :]] = -np.inf
+        h = np.sum(np.exp(spans) * inputs[:, None], axis=2) + start
+
+    return np.sum(h * c[:, :, None, :], axis=-1), h[:, -1]
+
+
+def random_feeds(session, rng):
+    # The sequence axis takes the block; batch axes (make_batch_dynamic.py
+    # names them "batch", first or second) take 1
+    feeds = {}
+
+    for value in session.get_inputs():
+        shape = [d if isinstance(d, int) else (1 if d is None or d == BATCH_AXIS else CHECK_BLOCK_SIZE)
+                 for d in value.shape]
+        feeds[value.name] = (0.5 * rng.standard_normal(shape)).astype(np.float32)
+
+    return feeds
+
+
+def check_scans(source, scans):
+    try:
+        import onnxruntime
+    except ImportError:
+        print("onnxruntime not installed, skipping the checks")
+        return
+
+    # The original model, with every tensor a scan reads or writes as an output
+    model = onnx.load(source)
+    existing = {output.name for output in model.graph.output}
+
+    for scan in scans:
+        for name in scan["inputs"] + scan["outputs"]:
+            if name not in existing and name not in {init.name for init in model.graph.initializer}:
+                model.graph.output.append(helper.make_empty_tensor_value_info(name))
+                existing.add(name)
+
+    session = onnxruntime.InferenceSession(model.SerializeToString(), providers=["CPUExecutionProvider"])
+    feeds = random_feeds(session, np.random.default_rng(2))
+    names = [output.name for output in session.get_outputs()]
+    values = dict(zip(names, session.run(names, feeds)))
+    values.update(feeds)
+    values.update({init.name: numpy_helper.to_array(init) for init in model.graph.initializer})
+
+    def largest(first, second):
+        return max(float(np.max(np.abs(a - b))) for a, b in zip(first, second))
+
+    for scan in scans:
+        tensors = [values[name] for name in scan["inputs"]]
+        exported = [values[name] for name in scan["outputs"]]
+        guarded = parallel_scan(*tensors, guarded=True)
+        exact = parallel_scan(*tensors, guarded=False)
+        print("%s, %d steps: match %.3g, operator %.3g (the nodes against the exact scan: %.3g)"
+              % (scan["name"], CHECK_BLOCK_SIZE, largest(guarded, exported),
+                 largest(recurrent_scan(*tensors), guarded), largest(exported, exact)))
+
+
+def check_fused(source, destination, library):
+    import onnxruntime
+
+    options = onnxruntime.SessionOptions()
+    options.register_custom_ops_library(library)
+    fused = onnxruntime.InferenceSession(destination, options, providers=["CPUExecutionProvider"])
+    original = onnxruntime.InferenceSession(source, providers=["CPUExecutionProvider"])
+
+    feeds = random_feeds(original, np.random.default_rng(3))
+    largest = max(float(np.max(np.abs(a - b))) for a, b in zip(original.run(None, feeds), fused.run(None, feeds)))
+    print("fused model against the original, %d samples: max difference %.3g" % (CHECK_BLOCK_SIZE, largest))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("source")
+    parser.add_argument("destination", nargs="?")
+    parser.add_argument("--custom-op-library")
+    args = parser.parse_args()
+
+    destination = args.destination or args.source
+    model = onnx.load(args.source)
+    scans = find_scans(model)
+
+    if not scans:
+        print("%s: no selective scan found, nothing to do" % args.source)
+        return 0
+
+    check_scans(args.source, scans)
+    fuse(model, scans)
+
+    onnx.checker.check_model(model)
+    onnx.save(model, destination)
+    print("%s: fused %d selective scan(s) -> %s" % (args.source, len(scans), destination))
+
+    if args.custom_op_library:
+        check_fused(args.source, destination, args.custom_op_library)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
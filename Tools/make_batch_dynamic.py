@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Rewrites an exported model so that its batch dimension is dynamic, which lets
+the plugins run both stereo channels through a single ONNX Runtime call.
+
+The PyTorch exports fix the batch size to 1 on every graph input and output.
+This script makes that dimension a symbolic "batch" and drops the intermediate
+shape annotations that repeat it:
+
+    input, controls     [1, sequence_length, 1]  ->  [batch, sequence_length, 1]
+    Mamba states        [1, 1, N]                ->  [batch, 1, N]
+    GRU / LSTM states   [1, 1, H]                ->  [1, batch, H]
+    conv histories      [1, channels, k - 1]     ->  [batch, channels, k - 1]
+
+A state's batch axis follows from its consumer: the initial_h / initial_c
+inputs of an RNN node are [num_directions, batch, hidden], everything else is
+batch-first. Each new_* output takes the axis of the input it replaces.
+
+The plugins check the first dimension of the model's first input when they
+load it, and only pack the channels when it is dynamic, so a rewritten model is
+a drop-in replacement for the original file. If onnxruntime is installed, the
+script also runs a two-item batch against two single runs on random input and
+prints the largest difference. Check it: a reshape inside the graph that
+assumes a batch of 1 shows up there, not as a load error. Models with fused
+selective scans (fuse_selective_scan.py, before or after this script) need
+the operator built as a library for that check (--custom-op-library, see
+Tools/SelectiveScanOpLibrary.cpp); without it the check is skipped.
+
+Usage:
+    python3 make_batch_dynamic.py ../NeuralPiano/Models/NeuralPiano_up.onnx [output.onnx]
+        [--custom-op-library libneural_ops.so]
+
+Requires the `onnx` Python package.
+"""
+
+import argparse
+import sys
+
+import onnx
+
+import numpy as np
+
+
+RNN_STATE_INPUTS = {"GRU": (5,), "RNN": (5,), "LSTM": (5, 6)}
+
+
+def batch_axis(graph, name):
+    for node in graph.node:
+        for index in RNN_STATE_INPUTS.get(node.op_type, ()):
+            if len(node.input) > index and node.input[index] == name:
+                return 1
+    return 0
+
+
+def set_batch_dim(value_info, axis):
+    dims = value_info.type.tensor_type.shape.dim
+
+    if len(dims) <= axis:
+        return False
+
+    dims[axis].Clear()
+    dims[axis].dim_param = "batch"
+    return True
+
+
+def make_batch_dynamic(model):
+    graph = model.graph
+    axes = {}
+
+    for value in graph.input:
+        axes[value.name] = batch_axis(graph, value.name)
+        set_batch_dim(value, axes[value.name])
+
+    for value in graph.output:
+        source = value.name[len("new_"):] if value.name.startswith("new_") else None
+        set_batch_dim(value, axes.get(source, 0))
+
+    # Inferred shapes of intermediate values would still say 1
+    del graph.value_info[:]
+    return len(graph.input)
+
+
+def compare_batches(path, custom_op_library):
+    try:
+        import onnxruntime
+    except ImportError:
+        print("onnxruntime not installed, skipping the batch check")
+        return
+
+    model = onnx.load(path)
+    options = onnxruntime.SessionOptions()
+
+    if custom_op_library:
+        options.register_custom_ops_library(custom_op_library)
+    elif any(node.domain not in ("", "ai.onnx") for node in model.graph.node):
+        print("custom operators in the graph and no --custom-op-library, skipping the batch check")
+        return
+
+    session = onnxruntime.InferenceSession(path, options, providers=["CPUExecutionProvider"])
+    axes = {value.name: batch_axis(model.graph, value.name) for value in model.graph.input}
+    rng = np.random.default_rng(1)
+    feeds = []
+
+    for channel in range(2):
+        feed = {}
+
+        for value in session.get_inputs():
+            shape = [1 if isinstance(d, str) or d is None else d for d in value.shape]
+            shape[1] = 64 if axes[value.name] == 0 and isinstance(value.shape[1], str) else shape[1]
+            feed[value.name] = (0.1 * rng.standard_normal(shape)).astype(np.float32)
+
+        feeds.append(feed)
+
+    single = [session.run(None, feed) for feed in feeds]
+    batched = session.run(None, {name: np.concatenate([feeds[0][name], feeds[1][name]], axis=axes[name])
+                                 for name in feeds[0]})
+
+    largest = 0.0
+
+    for index, output in enumerate(session.get_outputs()):
+        axis = axes.get(output.name[len("new_"):], 0) if output.name.startswith("new_") else 0
+        expected = np.concatenate([single[0][index], single[1][index]], axis=axis)
+        largest = max(largest, float(np.max(np.abs(expected - batched[index]))))
+
+    print("batch of 2 against two single runs: max difference %.3g" % largest)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("source")
+    parser.add_argument("destination", nargs="?")
+    parser.add_argument("--custom-op-library")
+    args = parser.parse_args()
+
+    source = args.source
+    destination = args.destination or source
+
+    model = onnx.load(source)
+    rewritten = make_batch_dynamic(model)
+
+    onnx.checker.check_model(model)
+    onnx.save(model, destination)
+    print("%s: dynamic batch on %d input(s) -> %s" % (source, rewritten, destination))
+
+    compare_batches(destination, args.custom_op_library)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())